@@ -0,0 +1,98 @@
+#pragma once
+
+#include "gameplay.h"
+
+
+
+// @optimize: should decrease MAX_ENTITIES_PER_TILE when game is finished or when related design decisions are final
+#define TILE_MAP_WIDTH              17
+#define TILE_MAP_HEIGHT             11
+#define TILE_COUNT                  (TILE_MAP_WIDTH * TILE_MAP_HEIGHT)
+#define MAX_GAMEPLAY_ENTITIES       TILE_COUNT
+#define MAX_ENTITIES_PER_TILE       10                                  // potential game object count in an single tile
+#define TEST_ARENA_ENTITY_COUNT     20
+#define TEST_ARENA_TRIGGER_COUNT    4
+#define TEST_ARENA_MIN_WIDTH        17                                  // the spawn and trigger tiles need at least a 17x11 map
+#define TEST_ARENA_MIN_HEIGHT       11
+
+
+
+/* test arena stuff (shared by client and server so both simulate the same match) */
+static const int test_arena_spawn_tiles[TEST_ARENA_ENTITY_COUNT][2] = // [x,y] tile of each entity, entity 0 is the player
+{
+  {2,3}, {4,5}, {6,7}, {8,3}, {3,7}, {4,7}, {7,8}, {6,9}, {11,6}, {9,4},
+  {2,9}, {5,4}, {13,8}, {8,5}, {4,9}, {7,3}, {6,5}, {5,9}, {5,7}, {5,1}
+};
+
+static const int test_arena_trigger_tiles[TEST_ARENA_TRIGGER_COUNT][2] = // [x,y] tile of each TEST trigger
+{
+  {1,1}, {11,2}, {12,3}, {14,5}
+};
+
+template<int p_width, int p_height>
+void generate_test_arena_bitmap(tile_map<p_width,p_height>& p_tile_map)
+{
+  assert( (p_tile_map.width >= TEST_ARENA_MIN_WIDTH) && (p_tile_map.height >= TEST_ARENA_MIN_HEIGHT) );
+
+  // generate walls
+  for(int i=0; i < p_tile_map.width; ++i)
+  {
+    p_tile_map.bitmap[i] = static_cast<int>(tile_map_bitmap_type::WALL);
+  }
+
+  for(int i=0; i < p_tile_map.height; ++i)
+  {
+    p_tile_map.bitmap[i * p_tile_map.width] = static_cast<int>(tile_map_bitmap_type::WALL);
+  }
+
+  for(int i=(p_tile_map.tile_count - p_tile_map.width); i < p_tile_map.tile_count; ++i)
+  {
+    p_tile_map.bitmap[i] = static_cast<int>(tile_map_bitmap_type::WALL);
+  }
+
+  for(int i=1; i < p_tile_map.height; ++i)
+  {
+    p_tile_map.bitmap[(i * p_tile_map.width) + (p_tile_map.width - 1)] = static_cast<int>(tile_map_bitmap_type::WALL);
+  }
+
+  for(int tile_index = (p_tile_map.width * 2); tile_index < p_tile_map.tile_count; tile_index += (p_tile_map.width * 2))
+  {
+    for(int tile_index_offset=1; tile_index_offset < p_tile_map.width; ++tile_index_offset)
+    {
+      if (tile_index_offset % 2 == 0)
+        p_tile_map.bitmap[tile_index + tile_index_offset] = static_cast<int>(tile_map_bitmap_type::WALL);
+    }
+  }
+
+  // create tile_map triggers
+  for(int i=0; i < TEST_ARENA_TRIGGER_COUNT; ++i)
+  {
+    p_tile_map.bitmap[(test_arena_trigger_tiles[i][1] * p_tile_map.width) + test_arena_trigger_tiles[i][0]] = static_cast<int>(tile_map_bitmap_type::TEST);
+  }
+}
+
+template<int p_width, int p_height>
+void register_test_arena_triggers(tile_triggers<p_width,p_height>& p_tile_triggers, const tile_map<p_width,p_height>& p_tile_map)  // the TEST tiles from generate_test_arena_bitmap
+{
+  for(int i=0; i < TEST_ARENA_TRIGGER_COUNT; ++i)
+  {
+    p_tile_triggers.add_trigger( (test_arena_trigger_tiles[i][1] * p_tile_map.width) + test_arena_trigger_tiles[i][0], tile_trigger_type::TEST );
+  }
+}
+
+template<int p_max_size, int p_width, int p_height>
+void spawn_test_arena_entities(gameplay_entities<p_max_size>& p_gameplay_entities, const tile_map<p_width,p_height>& p_tile_map)
+{
+  static_assert(p_max_size >= TEST_ARENA_ENTITY_COUNT, "Not enough gameplay entities for test arena");
+  assert( (p_tile_map.width >= TEST_ARENA_MIN_WIDTH) && (p_tile_map.height >= TEST_ARENA_MIN_HEIGHT) );
+
+  // the collision rectangle is inset by 1.0f to currently handle overlapping tile vertices
+  const sf::Vector2f collision_size(p_tile_map.tile_size_x - 2.0f, p_tile_map.tile_size_y - 2.0f);
+
+  // spawn order gives the player id 0 and the bombs ids 1..19
+  for(int i=0; i < TEST_ARENA_ENTITY_COUNT; ++i)
+  {
+    const sf::Vector2f origin_position( (p_tile_map.tile_size_x * test_arena_spawn_tiles[i][0]) + 1.0f, (test_arena_spawn_tiles[i][1] * p_tile_map.tile_size_y) + 1.0f );
+    p_gameplay_entities.spawn( (i == 0) ? gameplay_entity_type::MARIO : gameplay_entity_type::BOMB, origin_position, collision_size );
+  }
+}
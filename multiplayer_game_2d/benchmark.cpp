@@ -0,0 +1,430 @@
+#include <iostream>
+#include <iomanip>
+#include <string.h>
+#include <bitset>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <assert.h>
+#include <limits>
+#include "gameplay.h"
+#include "snapshot.h"
+#include "state_hash.h"
+
+#ifdef BENCHMARK_RENDERING
+  #include "gameplay_render.h"
+#endif
+
+
+// @remember: headless microbenchmarks for the per-tick hot paths, build with -DBENCHMARK_RENDERING (and link SFML) to also measure update_tex_coords
+// @remember: output is csv so results can be diffed between builds
+// @remember: "benchmark check [tick_count] [seed]" runs the same random walk through every movement kernel this build has (scalar, SSE, AVX) and exits 1 unless their positions stay bit identical
+
+
+#define BENCHMARK_TILE_SIZE             64.0f
+#define BENCHMARK_MAX_ENTITIES_PER_TILE 10
+#define BENCHMARK_MIN_ENTITY_COUNT      20
+#define BENCHMARK_MAX_ENTITY_COUNT      100000
+#define BENCHMARK_TICK_SECONDS          (1.0f / 60.0f)
+#define BENCHMARK_ENTITY_SPEED          250.0f          // world units per second
+#define BENCHMARK_TARGET_SLOT_TICKS     20000000        // ticks * slots per configuration so large maps don't take forever
+#define BENCHMARK_CHECK_TICK_COUNT      2000
+#define BENCHMARK_CHECK_DENSITY         0.5f            // crowded enough for chains and blocked moves every tick
+
+
+
+/* allocation counting stuff */
+// @remember: the replacements stay out of line, inlined into callers g++ pairs their malloc/free with the new/delete expressions and warns (-Wmismatched-new-delete) at -O1 and above
+#if defined(_MSC_VER)
+  #define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+  #define BENCHMARK_NOINLINE __attribute__((noinline))
+#endif
+
+static long long benchmark_allocation_count = 0;
+
+BENCHMARK_NOINLINE void* operator new(std::size_t size)
+{
+  ++benchmark_allocation_count;
+  void* memory = malloc(size ? size : 1);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+BENCHMARK_NOINLINE void* operator new[](std::size_t size)
+{
+  ++benchmark_allocation_count;
+  void* memory = malloc(size ? size : 1);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+BENCHMARK_NOINLINE void operator delete(void* memory) noexcept                     { free(memory); }
+BENCHMARK_NOINLINE void operator delete[](void* memory) noexcept                   { free(memory); }
+BENCHMARK_NOINLINE void operator delete(void* memory, std::size_t) noexcept        { free(memory); }
+BENCHMARK_NOINLINE void operator delete[](void* memory, std::size_t) noexcept      { free(memory); }
+
+
+
+/* timing stuff */
+static volatile float benchmark_sink = 0.0f;
+
+struct benchmark_result
+{
+  const char* name;
+  long long   total_nanoseconds = 0;
+  long long   allocation_count  = 0;
+  long long   total_bytes       = 0;   // only set by the serializers
+  int         call_count        = 0;
+
+  explicit benchmark_result(const char* p_name) : name(p_name) {}
+};
+
+template<typename t_function>
+inline void time_call(benchmark_result& result, t_function function)
+{
+  long long allocation_count_before = benchmark_allocation_count;
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+  function();
+
+  result.total_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+  result.allocation_count  += benchmark_allocation_count - allocation_count_before;
+  ++result.call_count;
+}
+
+inline void print_result(const benchmark_result& result, const int width, const int height, const char* map_kind, const float density, const int entity_count)
+{
+  double nanoseconds_per_call   = static_cast<double>(result.total_nanoseconds) / result.call_count;
+  double nanoseconds_per_entity = nanoseconds_per_call / entity_count;
+  double allocations_per_call   = static_cast<double>(result.allocation_count) / result.call_count;
+  double bytes_per_call         = static_cast<double>(result.total_bytes) / result.call_count;
+
+  std::cout << result.name << "," << width << "x" << height << "," << map_kind << "," << density << "," << entity_count << ","
+            << std::fixed << std::setprecision(1) << nanoseconds_per_call << "," << std::setprecision(3) << nanoseconds_per_entity << ","
+            << std::setprecision(2) << allocations_per_call << "," << std::setprecision(1) << bytes_per_call << std::defaultfloat << std::endl;
+}
+
+
+
+/* arena stuff */
+inline int benchmark_entity_count(const int width, const int height, const float density)
+{
+  const int interior_count = (width - 2) * (height - 2);
+  int entity_count         = static_cast<int>(interior_count * density);
+  if (entity_count > BENCHMARK_MAX_ENTITY_COUNT) entity_count = BENCHMARK_MAX_ENTITY_COUNT;
+  if (entity_count < BENCHMARK_MIN_ENTITY_COUNT) entity_count = std::min(BENCHMARK_MIN_ENTITY_COUNT, interior_count);
+  return entity_count;
+}
+
+template<int p_width, int p_height, int p_max_gameplay_entities>
+void setup_benchmark_arena(tile_map<p_width,p_height>& p_tile_map, gameplay_entities<p_max_gameplay_entities>& p_gameplay_entities, const int entity_count, std::mt19937& random_generator)
+{
+  const int width      = p_tile_map.width;
+  const int height     = p_tile_map.height;
+  const int tile_count = p_tile_map.tile_count;
+
+  // border walls only so chains always end
+  for(int x=0; x < width; ++x)
+  {
+    p_tile_map.bitmap[x] = static_cast<int>(tile_map_bitmap_type::WALL);
+    p_tile_map.bitmap[tile_count - width + x] = static_cast<int>(tile_map_bitmap_type::WALL);
+  }
+  for(int y=0; y < height; ++y)
+  {
+    p_tile_map.bitmap[y * width] = static_cast<int>(tile_map_bitmap_type::WALL);
+    p_tile_map.bitmap[(y * width) + width - 1] = static_cast<int>(tile_map_bitmap_type::WALL);
+  }
+
+  // spawn entities on random unique interior tiles
+  std::vector<int> interior_tiles;
+  interior_tiles.reserve((width - 2) * (height - 2));
+  for(int y=1; y < height - 1; ++y)
+  for(int x=1; x < width - 1;  ++x)
+  {
+    interior_tiles.push_back((y * width) + x);
+  }
+  std::shuffle(interior_tiles.begin(), interior_tiles.end(), random_generator);
+
+  for(int id=0; id < entity_count; ++id)
+  {
+    int tile_index = interior_tiles[id];
+    sf::Vector2f origin( (tile_index % width) * p_tile_map.tile_size_x, (tile_index / width) * p_tile_map.tile_size_y );
+
+    p_gameplay_entities.spawn( (id == 0) ? gameplay_entity_type::MARIO : gameplay_entity_type::BOMB, origin + sf::Vector2f(1.0f, 1.0f), sf::Vector2f(p_tile_map.tile_size_x - 2.0f, p_tile_map.tile_size_y - 2.0f) );
+  }
+}
+
+inline void generate_random_walk_requests(generate_move_request_input* const move_request_inputs, const int entity_count, std::mt19937& random_generator)  // every entity requests a random direction
+{
+  static const sf::Vector2f directions[4] = { sf::Vector2f(1.0f,0.0f), sf::Vector2f(-1.0f,0.0f), sf::Vector2f(0.0f,1.0f), sf::Vector2f(0.0f,-1.0f) };
+  std::uniform_int_distribution<int> direction_distribution(0, 3);
+
+  for(int id=0; id < entity_count; ++id)
+  {
+    move_request_inputs[id].gameplay_entity_id = id;
+    move_request_inputs[id].velocity = directions[direction_distribution(random_generator)] * BENCHMARK_ENTITY_SPEED;
+  }
+}
+
+
+
+/* benchmark stuff */
+template<int p_width, int p_height, int p_max_gameplay_entities>
+void run_benchmarks(const int width, const int height, const float density, const unsigned int seed)
+{
+  const int tile_count   = width * height;
+  const int entity_count = benchmark_entity_count(width, height, density);
+
+  typedef tile_map<p_width,p_height>                                                                               benchmark_tile_map;
+  typedef gameplay_entities<p_max_gameplay_entities>                                                               benchmark_entities;
+  typedef gameplay_entity_ids_per_tile<p_width,p_height,p_max_gameplay_entities,BENCHMARK_MAX_ENTITIES_PER_TILE>  benchmark_entity_ids_per_tile;
+  typedef gameplay_entity_ids_per_tile_compact<p_width,p_height,p_max_gameplay_entities>                           benchmark_entity_ids_per_tile_compact;
+  typedef gameplay_entity_moves<p_max_gameplay_entities,p_width,p_height>                                          benchmark_entity_moves;
+
+  assert(tile_count <= p_max_gameplay_entities);
+
+  benchmark_tile_map* test_tile_map = new benchmark_tile_map(width, height, BENCHMARK_TILE_SIZE * width, BENCHMARK_TILE_SIZE * height);
+  benchmark_entities* all_gameplay_entities = new benchmark_entities();
+  benchmark_entity_ids_per_tile* tile_to_gameplay_entities = new benchmark_entity_ids_per_tile(*test_tile_map);
+  benchmark_entity_ids_per_tile* incremental_tile_to_gameplay_entities = new benchmark_entity_ids_per_tile(*test_tile_map);  // only re-bins moved entities so it's timed separately from the full rebuild
+  benchmark_entity_ids_per_tile_compact* compact_tile_to_gameplay_entities = new benchmark_entity_ids_per_tile_compact(*test_tile_map);
+
+  std::mt19937 random_generator(seed);
+  setup_benchmark_arena(*test_tile_map, *all_gameplay_entities, entity_count, random_generator);
+
+  incremental_tile_to_gameplay_entities->update(*test_tile_map, *all_gameplay_entities);
+
+  benchmark_entity_moves* all_entity_moves = new benchmark_entity_moves(all_gameplay_entities->all_collision_vertices_origin_positions(), all_gameplay_entities->is_garbage_flags, *test_tile_map);
+  gameplay_entity_move_request* all_move_requests = new gameplay_entity_move_request[tile_count];
+  generate_move_request_input* move_request_inputs = new generate_move_request_input[entity_count];
+
+  // a whole snapshot of every entity, not capped to a datagram so large maps measure throughput
+  const snapshot_layout layout(static_cast<std::uint32_t>(tile_count), p_max_gameplay_entities);
+  const int snapshot_capacity = ((entity_count * layout.max_entity_bits()) / 8) + 8;
+  std::uint8_t* snapshot_buffer = new std::uint8_t[snapshot_capacity];
+  snapshot_entity* read_snapshot_entities = new snapshot_entity[entity_count];
+  int snapshot_size = 0;
+
+  #ifdef BENCHMARK_RENDERING
+    gameplay_entity_sprites<p_max_gameplay_entities>* all_gameplay_entity_sprites = new gameplay_entity_sprites<p_max_gameplay_entities>("Assets/Images/gameplay_entities.png", 64 * 3);
+  #endif
+
+  // every entity requests a random move each tick, submit_all_moves ignores the ones already moving
+  const int tick_count = std::max(10, std::min(1000, BENCHMARK_TARGET_SLOT_TICKS / p_max_gameplay_entities));
+
+  benchmark_result submit_all_moves_result("submit_all_moves");
+  benchmark_result update_by_velocities_result("update_by_velocities");
+  benchmark_result set_all_positions_result("set_all_positions");
+  benchmark_result tile_buckets_update_result("gameplay_entity_ids_per_tile::update");
+  benchmark_result tile_buckets_update_moved_result("gameplay_entity_ids_per_tile::update_moved_entities");
+  benchmark_result compact_tile_buckets_update_result("gameplay_entity_ids_per_tile_compact::update");
+  benchmark_result snapshot_write_result("snapshot_write");
+  benchmark_result snapshot_read_result("snapshot_read");
+  #ifdef BENCHMARK_RENDERING
+    benchmark_result update_tex_coords_result("update_tex_coords");
+  #endif
+
+  for(int tick=0; tick < tick_count; ++tick)
+  {
+    for (int i=0; i < all_gameplay_entities->live_count; ++i) all_move_requests[all_gameplay_entities->live_ids[i]].velocity = sf::Vector2f(0.0f,0.0f);
+
+    generate_random_walk_requests(move_request_inputs, entity_count, random_generator);
+    all_gameplay_entities->generate_move_requests(move_request_inputs, all_move_requests, entity_count, test_tile_map->tile_size_x, test_tile_map->tile_size_y);
+
+    time_call(submit_all_moves_result,     [&]() { all_entity_moves->submit_all_moves(all_move_requests, *test_tile_map, *all_gameplay_entities); });
+    time_call(update_by_velocities_result, [&]() { all_entity_moves->update_by_velocities(BENCHMARK_TICK_SECONDS, *test_tile_map, *all_gameplay_entities); });
+    time_call(set_all_positions_result,    [&]() { all_gameplay_entities->set_all_positions(all_entity_moves->current_origin_x, all_entity_moves->current_origin_y); });
+    time_call(tile_buckets_update_result,  [&]() { tile_to_gameplay_entities->update(*test_tile_map, *all_gameplay_entities); });
+    time_call(tile_buckets_update_moved_result, [&]() { incremental_tile_to_gameplay_entities->update_moved_entities(*test_tile_map, *all_gameplay_entities, all_entity_moves->moved_ids, all_entity_moves->moved_count); });
+    time_call(compact_tile_buckets_update_result, [&]() { compact_tile_to_gameplay_entities->update(*test_tile_map, *all_gameplay_entities); });
+    time_call(snapshot_write_result, [&]()
+    {
+      bit_writer writer(snapshot_buffer, snapshot_capacity);
+      for(int i=0; i < all_gameplay_entities->live_count; ++i) quantize_entity(all_gameplay_entities->live_ids[i], *all_gameplay_entities, *all_entity_moves, *test_tile_map).write(writer, layout);
+      writer.flush();
+      assert(!writer.overflowed);
+      snapshot_size = writer.size;
+    });
+    time_call(snapshot_read_result, [&]()
+    {
+      bit_reader reader(snapshot_buffer, snapshot_size);
+      float position_sum = 0.0f;
+      for(int i=0; i < all_gameplay_entities->live_count; ++i)
+      {
+        read_snapshot_entities[i].read(reader, layout);
+        position_sum += dequantize_origin_position(read_snapshot_entities[i], *test_tile_map).x;
+      }
+      benchmark_sink = position_sum;  // keeps the dequantize from being optimized away
+    });
+    snapshot_write_result.total_bytes += snapshot_size;
+    snapshot_read_result.total_bytes  += snapshot_size;
+    #ifdef BENCHMARK_RENDERING
+      time_call(update_tex_coords_result,  [&]() { all_gameplay_entity_sprites->update_tex_coords(*all_gameplay_entities, BENCHMARK_TICK_SECONDS); });
+    #endif
+  }
+
+  const char* map_kind = (p_width == RUNTIME_TILE_MAP_SIZE) ? "runtime" : "compile_time";
+
+  print_result(submit_all_moves_result,     width, height, map_kind, density, entity_count);
+  print_result(update_by_velocities_result, width, height, map_kind, density, entity_count);
+  print_result(set_all_positions_result,    width, height, map_kind, density, entity_count);
+  print_result(tile_buckets_update_result,  width, height, map_kind, density, entity_count);
+  print_result(tile_buckets_update_moved_result, width, height, map_kind, density, entity_count);
+  print_result(compact_tile_buckets_update_result, width, height, map_kind, density, entity_count);
+  print_result(snapshot_write_result, width, height, map_kind, density, entity_count);
+  print_result(snapshot_read_result,  width, height, map_kind, density, entity_count);
+  #ifdef BENCHMARK_RENDERING
+    print_result(update_tex_coords_result,  width, height, map_kind, density, entity_count);
+    delete all_gameplay_entity_sprites;
+  #endif
+
+  delete[] read_snapshot_entities;
+  delete[] snapshot_buffer;
+  delete[] move_request_inputs;
+  delete[] all_move_requests;
+  delete all_entity_moves;
+  delete compact_tile_to_gameplay_entities;
+  delete incremental_tile_to_gameplay_entities;
+  delete tile_to_gameplay_entities;
+  delete all_gameplay_entities;
+  delete test_tile_map;
+}
+
+template<int p_width, int p_height, int p_max_gameplay_entities>
+void run_benchmarks_for_all_densities(const int width, const int height, const int max_map_side_length, const unsigned int seed)
+{
+  static const float densities[] = { 0.01f, 0.1f, 0.5f, 0.9f };
+
+  if ( (width > max_map_side_length) || (height > max_map_side_length) ) return;
+
+  for(const float density : densities)
+  {
+    run_benchmarks<p_width,p_height,p_max_gameplay_entities>(width, height, density, seed);
+  }
+}
+
+
+
+/* kernel check stuff */
+template<int p_width, int p_height, int p_max_gameplay_entities, int p_simd_width>
+std::vector<std::uint64_t> run_movement_kernel(const int width, const int height, const int tick_count, const unsigned int seed)  // the hash of every live entity's position and velocity after each tick
+{
+  typedef tile_map<p_width,p_height>                                      check_tile_map;
+  typedef gameplay_entities<p_max_gameplay_entities>                      check_entities;
+  typedef gameplay_entity_moves<p_max_gameplay_entities,p_width,p_height> check_entity_moves;
+
+  const int entity_count = benchmark_entity_count(width, height, BENCHMARK_CHECK_DENSITY);
+
+  check_tile_map* test_tile_map = new check_tile_map(width, height, BENCHMARK_TILE_SIZE * width, BENCHMARK_TILE_SIZE * height);
+  check_entities* all_gameplay_entities = new check_entities();
+  std::mt19937 random_generator(seed);
+  setup_benchmark_arena(*test_tile_map, *all_gameplay_entities, entity_count, random_generator);
+
+  check_entity_moves* all_entity_moves = new check_entity_moves(all_gameplay_entities->all_collision_vertices_origin_positions(), all_gameplay_entities->is_garbage_flags, *test_tile_map);
+  gameplay_entity_move_request* all_move_requests = new gameplay_entity_move_request[test_tile_map->tile_count];
+  generate_move_request_input* move_request_inputs = new generate_move_request_input[entity_count];
+
+  std::vector<std::uint64_t> tick_hashes;
+  tick_hashes.reserve(tick_count);
+  for(int tick=0; tick < tick_count; ++tick)
+  {
+    for (int i=0; i < all_gameplay_entities->live_count; ++i) all_move_requests[all_gameplay_entities->live_ids[i]].velocity = sf::Vector2f(0.0f,0.0f);
+
+    generate_random_walk_requests(move_request_inputs, entity_count, random_generator);
+    all_gameplay_entities->generate_move_requests(move_request_inputs, all_move_requests, entity_count, test_tile_map->tile_size_x, test_tile_map->tile_size_y);
+    all_entity_moves->submit_all_moves(all_move_requests, *test_tile_map, *all_gameplay_entities);
+    all_entity_moves->template update_by_velocities<p_simd_width>(BENCHMARK_TICK_SECONDS, *test_tile_map, *all_gameplay_entities);
+    all_gameplay_entities->set_all_positions(all_entity_moves->current_origin_x, all_entity_moves->current_origin_y);
+
+    state_hasher hasher;
+    for(int live_index=0; live_index < all_gameplay_entities->live_count; ++live_index)
+    {
+      const int id = all_gameplay_entities->live_ids[live_index];
+      hasher.add(static_cast<std::uint32_t>(id));
+      hasher.add(all_entity_moves->current_origin_x[id]);
+      hasher.add(all_entity_moves->current_origin_y[id]);
+      hasher.add(all_entity_moves->velocity_x[id]);
+      hasher.add(all_entity_moves->velocity_y[id]);
+    }
+    tick_hashes.push_back(hasher.value);
+  }
+
+  delete[] move_request_inputs;
+  delete[] all_move_requests;
+  delete all_entity_moves;
+  delete all_gameplay_entities;
+  delete test_tile_map;
+  return tick_hashes;
+}
+
+template<int p_width, int p_height, int p_max_gameplay_entities>
+bool check_movement_kernels(const int width, const int height, const int tick_count, const unsigned int seed)  // true when every kernel matches the scalar one on every tick
+{
+  const std::vector<std::uint64_t> scalar_hashes = run_movement_kernel<p_width,p_height,p_max_gameplay_entities,1>(width, height, tick_count, seed);
+  const char* const map_kind = (p_width == RUNTIME_TILE_MAP_SIZE) ? "runtime" : "compile_time";
+  bool is_identical = true;
+
+  auto compare = [&](const char* const kernel_name, const std::vector<std::uint64_t>& kernel_hashes)
+  {
+    int diverged_tick = -1;
+    for(int tick=0; tick < tick_count; ++tick)
+    {
+      if (kernel_hashes[tick] == scalar_hashes[tick]) continue;
+      diverged_tick = tick + 1;
+      break;
+    }
+
+    std::cout << width << "x" << height << " " << map_kind << " " << kernel_name << " vs scalar: ";
+    if (diverged_tick == -1) std::cout << tick_count << " ticks bit identical" << std::endl;
+    else                     std::cout << "positions differ from tick " << diverged_tick << std::endl;
+    is_identical = is_identical && (diverged_tick == -1);
+  };
+
+  #if GAMEPLAY_SIMD_WIDTH >= 4
+    compare("sse", run_movement_kernel<p_width,p_height,p_max_gameplay_entities,4>(width, height, tick_count, seed));
+  #endif
+  #if GAMEPLAY_SIMD_WIDTH >= 8
+    compare("avx", run_movement_kernel<p_width,p_height,p_max_gameplay_entities,8>(width, height, tick_count, seed));
+  #endif
+  #if GAMEPLAY_SIMD_WIDTH == 1
+    (void) compare;
+    std::cout << width << "x" << height << " " << map_kind << " scalar only, this build has no vector movement kernel to compare" << std::endl;
+  #endif
+
+  return is_identical;
+}
+
+
+
+int main(int argc, char** argv)
+{
+  if ( (argc > 1) && (strcmp(argv[1], "check") == 0) )
+  {
+    const int          tick_count = (argc > 2) ? atoi(argv[2])                              : BENCHMARK_CHECK_TICK_COUNT;
+    const unsigned int seed       = (argc > 3) ? static_cast<unsigned int>(atoi(argv[3])) : 12345;
+
+    bool is_identical = check_movement_kernels<17,11,17 * 11>(17, 11, tick_count, seed);
+    is_identical      = check_movement_kernels<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE,17 * 11>(17, 11, tick_count, seed) && is_identical;
+    is_identical      = check_movement_kernels<64,64,64 * 64>(64, 64, tick_count, seed) && is_identical;
+    return is_identical ? 0 : 1;
+  }
+
+  const int          max_map_side_length = (argc > 1) ? atoi(argv[1]) : 1024;   // lets quick runs skip the large maps
+  const unsigned int seed                = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : 12345;
+
+  std::cout << "function,map,map_kind,density,entities,ns_per_call,ns_per_entity,allocations_per_call,bytes_per_call" << std::endl;
+
+  run_benchmarks_for_all_densities<17,11,17 * 11>(17, 11, max_map_side_length, seed);
+  run_benchmarks_for_all_densities<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE,17 * 11>(17, 11, max_map_side_length, seed);
+  run_benchmarks_for_all_densities<64,64,64 * 64>(64, 64, max_map_side_length, seed);
+  run_benchmarks_for_all_densities<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE,64 * 64>(64, 64, max_map_side_length, seed);
+  run_benchmarks_for_all_densities<256,256,256 * 256>(256, 256, max_map_side_length, seed);
+  run_benchmarks_for_all_densities<1024,1024,1024 * 1024>(1024, 1024, max_map_side_length, seed);
+
+  return 0;
+}
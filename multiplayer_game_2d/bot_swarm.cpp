@@ -0,0 +1,245 @@
+#include <iostream>
+#include <string.h>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <assert.h>
+#include "gameplay.h"
+#include "fixed_timestep.h"
+#include "net.h"
+#include "protocol.h"
+#include "net_client.h"
+
+
+/*
+   @remember: headless load generator, one process runs many bots against a server so server hardware can be sized by bot count
+   @remember: bots only decode STATE and send INPUT (no prediction, interpolation or rendering) so one core can drive many of them
+   @remember: input-to-ack latency is from sending an input until the first STATE that acks it, so it includes the server's input buffer delay and tick/send interval
+*/
+
+
+#define BOT_MAX_TICKS_PER_FRAME        5
+#define BOT_TICKS_PER_DIRECTION_CHANGE 30
+#define BOT_SEND_TIME_RING_SIZE        256   // inputs remembered for latency, must be a power of two and cover the inputs in flight
+
+
+
+/* bot stuff */
+enum class bot_profile : int
+{
+  RANDOM_WALK = 0,   // a new random direction every BOT_TICKS_PER_DIRECTION_CHANGE ticks, like test_client
+  CHASE       = 1,   // walks toward the nearest other entity it can see
+  INPUT_SPAM  = 2    // a new random direction every tick, the most STATE churn one player can cause
+};
+
+const char* const bot_profile_names[] = { "walk", "chase", "spam" };
+
+struct bot
+{
+  std::unique_ptr<net_client>               client;
+  std::unique_ptr<fixed_timestep_scheduler> scheduler;   // created once connected, at the server's tick rate
+  bot_profile                               profile   = bot_profile::RANDOM_WALK;
+  player_input_direction                    direction = player_input_direction::NONE;
+  std::minstd_rand                          random_generator;
+  std::uint32_t                             newest_acked_sequence = 0;
+  std::chrono::steady_clock::time_point     send_times[BOT_SEND_TIME_RING_SIZE];  // by input sequence
+};
+
+inline player_input_direction choose_chase_direction(const world_snapshot& state, const int own_id, const int map_width)  // toward the nearest other present entity, NONE when alone
+{
+  if ( (own_id < 0) || (own_id >= state.id_bound) || !state.entities[own_id].is_present() ) return player_input_direction::NONE;
+
+  const int own_x = state.entities[own_id].tile_index % map_width;
+  const int own_y = state.entities[own_id].tile_index / map_width;
+
+  int nearest_distance = -1;
+  int nearest_dx       = 0;
+  int nearest_dy       = 0;
+  for(int i=0; i < state.present_count; ++i)
+  {
+    const int id = state.present_ids[i];
+    if (id == own_id) continue;
+
+    const int dx       = (state.entities[id].tile_index % map_width) - own_x;
+    const int dy       = (state.entities[id].tile_index / map_width) - own_y;
+    const int distance = std::abs(dx) + std::abs(dy);
+    if ( (nearest_distance == -1) || (distance < nearest_distance) )
+    {
+      nearest_distance = distance;
+      nearest_dx       = dx;
+      nearest_dy       = dy;
+    }
+  }
+
+  if (nearest_distance <= 0) return player_input_direction::NONE;
+  if (std::abs(nearest_dx) >= std::abs(nearest_dy)) return (nearest_dx > 0) ? player_input_direction::RIGHT : player_input_direction::LEFT;
+  return (nearest_dy > 0) ? player_input_direction::DOWN : player_input_direction::UP;
+}
+
+inline float latency_percentile(const std::vector<float>& sorted_seconds, const float percentile)  // nearest rank, 0 when empty
+{
+  if (sorted_seconds.empty()) return 0.0f;
+
+  std::size_t rank = static_cast<std::size_t>( (percentile / 100.0f) * static_cast<float>(sorted_seconds.size()) );
+  if (rank >= sorted_seconds.size()) rank = sorted_seconds.size() - 1;
+  return sorted_seconds[rank];
+}
+
+
+
+int main(int argc, char** argv)
+{
+  const char*        server_ip    = (argc > 1) ? argv[1]                                  : "127.0.0.1";
+  const int          server_port  = (argc > 2) ? atoi(argv[2])                            : DEFAULT_SERVER_PORT;
+  const int          bot_count    = (argc > 3) ? atoi(argv[3])                            : MAX_CLIENTS;
+  const float        run_seconds  = (argc > 4) ? static_cast<float>(atof(argv[4]))        : 10.0f;
+  const char*        profile_name = (argc > 5) ? argv[5]                                  : "mix";
+  const unsigned int seed         = (argc > 6) ? static_cast<unsigned int>(atoi(argv[6])) : 1;
+
+  int profile_index = -1;  // -1 mixes the profiles round-robin
+  for(int i=0; i < 3; ++i)
+  {
+    if (strcmp(profile_name, bot_profile_names[i]) == 0) profile_index = i;
+  }
+
+  if ( (bot_count < 1) || ((profile_index == -1) && (strcmp(profile_name, "mix") != 0)) )
+  {
+    std::cout << "usage: bot_swarm <server_ip> [port] [bot_count] [run_seconds] [walk|chase|spam|mix] [seed]" << std::endl;
+    return 1;
+  }
+
+  if (!net_startup()) return 1;
+
+  std::vector<bot> bots(static_cast<std::size_t>(bot_count));
+  for(int i=0; i < bot_count; ++i)
+  {
+    bots[i].client.reset(new net_client());
+    bots[i].profile = static_cast<bot_profile>( (profile_index == -1) ? (i % 3) : profile_index );
+    bots[i].random_generator.seed(seed + static_cast<unsigned int>(i));
+
+    if ( !bots[i].client->start(server_ip, static_cast<std::uint16_t>(server_port)) )
+    {
+      std::cout << "could not start bot " << i << " for " << server_ip << ":" << server_port << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<float> latency_seconds;   // one sample per acked input
+  latency_seconds.reserve(static_cast<std::size_t>(bot_count * run_seconds * 64.0f));
+  std::uniform_int_distribution<int> direction_distribution(0, 4);
+  long long input_count = 0;
+
+  std::chrono::steady_clock::time_point start_time    = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point previous_time = start_time;
+
+  for(;;)
+  {
+    std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+    float elapsed_frame_time_seconds = std::chrono::duration<float>(current_time - previous_time).count();
+    previous_time = current_time;
+
+    if (std::chrono::duration<float>(current_time - start_time).count() >= run_seconds) break;
+
+    float seconds_until_next_tick = 0.001f;  // poll for the accept while nobody is connected
+    bool  is_anyone_running       = false;
+
+    for(bot& p_bot : bots)
+    {
+      net_client& client = *p_bot.client;
+      client.update(elapsed_frame_time_seconds);
+      if ( (client.state == net_client_state::DISCONNECTED) || (client.state == net_client_state::DENIED) ) continue;
+      is_anyone_running = true;
+
+      if ( (client.state == net_client_state::CONNECTED) && !p_bot.scheduler ) p_bot.scheduler.reset(new fixed_timestep_scheduler(client.accept.tick_rate, BOT_MAX_TICKS_PER_FRAME));
+
+      if (client.has_new_state)
+      {
+        // every input this STATE acks for the first time
+        const std::uint32_t acked_sequence = client.latest_acked_input_sequence;
+        if ( sequence_greater_than(acked_sequence, p_bot.newest_acked_sequence) )
+        {
+          std::uint32_t first_sequence = p_bot.newest_acked_sequence + 1;
+          if ( (acked_sequence - first_sequence) >= BOT_SEND_TIME_RING_SIZE ) first_sequence = acked_sequence - BOT_SEND_TIME_RING_SIZE + 1;
+
+          for(std::uint32_t sequence=first_sequence; sequence != acked_sequence + 1; ++sequence)
+          {
+            latency_seconds.push_back( std::chrono::duration<float>(current_time - p_bot.send_times[sequence & (BOT_SEND_TIME_RING_SIZE - 1)]).count() );
+          }
+          p_bot.newest_acked_sequence = acked_sequence;
+        }
+
+        client.has_new_state = false;
+      }
+
+      if (!p_bot.scheduler) continue;
+
+      int tick_count_this_frame = p_bot.scheduler->advance(elapsed_frame_time_seconds);
+      for(int tick=0; tick < tick_count_this_frame; ++tick)
+      {
+        switch (p_bot.profile)
+        {
+          case bot_profile::RANDOM_WALK:
+               if (p_bot.scheduler->tick_count % BOT_TICKS_PER_DIRECTION_CHANGE == 0) p_bot.direction = static_cast<player_input_direction>(direction_distribution(p_bot.random_generator));
+               break;
+
+          case bot_profile::CHASE:
+               p_bot.direction = choose_chase_direction(client.latest_state, client.accept.entity_id, client.accept.map_width);
+               break;
+
+          case bot_profile::INPUT_SPAM:
+               p_bot.direction = static_cast<player_input_direction>(direction_distribution(p_bot.random_generator));
+               break;
+        }
+
+        std::uint32_t sequence = client.send_input(p_bot.direction);
+        p_bot.send_times[sequence & (BOT_SEND_TIME_RING_SIZE - 1)] = std::chrono::steady_clock::now();
+        ++input_count;
+      }
+
+      if (p_bot.scheduler->seconds_until_next_tick() < seconds_until_next_tick) seconds_until_next_tick = p_bot.scheduler->seconds_until_next_tick();
+    }
+
+    if (!is_anyone_running) break;
+
+    std::this_thread::sleep_for( std::chrono::duration<float>(seconds_until_next_tick) );
+  }
+
+  const float elapsed_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+
+  int       connected_count         = 0;
+  int       denied_count            = 0;
+  long long state_count             = 0;
+  long long undecodable_state_count = 0;
+  long long sent_byte_count         = 0;
+  long long received_byte_count     = 0;
+  for(bot& p_bot : bots)
+  {
+    if (p_bot.scheduler) ++connected_count;
+    if (p_bot.client->state == net_client_state::DENIED) ++denied_count;
+    state_count             += p_bot.client->received_state_count;
+    undecodable_state_count += p_bot.client->undecodable_state_count;
+    sent_byte_count         += p_bot.client->sent_byte_count;
+    received_byte_count     += p_bot.client->received_byte_count;
+    p_bot.client->disconnect();
+  }
+
+  std::sort(latency_seconds.begin(), latency_seconds.end());
+
+  std::cout << "bot swarm ran " << bot_count << " " << profile_name << " bots for " << elapsed_seconds << " seconds: " << connected_count << " connected, " << denied_count << " denied" << std::endl;
+  std::cout << "sent " << input_count << " inputs, received " << state_count << " states (" << undecodable_state_count << " undecodable)" << std::endl;
+  if (connected_count > 0)
+  {
+    std::cout << "bandwidth per bot: up " << (sent_byte_count / connected_count / elapsed_seconds) << " B/s, down " << (received_byte_count / connected_count / elapsed_seconds) << " B/s"
+              << " (server total up " << (received_byte_count * 8.0f / elapsed_seconds / 1000.0f) << " kbit/s, down " << (sent_byte_count * 8.0f / elapsed_seconds / 1000.0f) << " kbit/s)" << std::endl;
+  }
+  std::cout << "input to ack latency over " << latency_seconds.size() << " inputs: p50 " << (latency_percentile(latency_seconds, 50.0f) * 1000.0f) << " ms, p90 " << (latency_percentile(latency_seconds, 90.0f) * 1000.0f)
+            << " ms, p99 " << (latency_percentile(latency_seconds, 99.0f) * 1000.0f) << " ms, max " << (latency_seconds.empty() ? 0.0f : latency_seconds.back() * 1000.0f) << " ms" << std::endl;
+
+  net_shutdown();
+
+  return (connected_count > 0) ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <assert.h>
+
+
+
+/* fixed timestep stuff */
+struct fixed_timestep_scheduler
+{
+  /*
+     @remember: the simulation always steps by tick_seconds so results don't depend on frame rate
+     @remember: call advance() once per frame, run the returned number of ticks, then render with interpolation_alpha()
+  */
+
+  const int   tick_rate_hz;
+  const float tick_seconds;
+  const int   max_ticks_per_frame;     // bounded catch-up so a long stall doesn't cause a spiral of ever longer frames
+  float       accumulator_seconds = 0.0f;
+  long long   tick_count          = 0; // total ticks run since start
+  long long   dropped_tick_count  = 0; // ticks skipped because catch-up was bounded
+
+  fixed_timestep_scheduler(const int p_tick_rate_hz, const int p_max_ticks_per_frame) : tick_rate_hz(p_tick_rate_hz), tick_seconds(1.0f / static_cast<float>(p_tick_rate_hz)), max_ticks_per_frame(p_max_ticks_per_frame)
+  {
+    assert(p_tick_rate_hz > 0);
+    assert(p_max_ticks_per_frame > 0);
+  }
+
+  int advance(const float elapsed_frame_time_seconds) // returns how many ticks to run this frame
+  {
+    accumulator_seconds += elapsed_frame_time_seconds;
+
+    int tick_count_this_frame = static_cast<int>(accumulator_seconds / tick_seconds);
+
+    if (tick_count_this_frame > max_ticks_per_frame)
+    {
+      dropped_tick_count   += tick_count_this_frame - max_ticks_per_frame;
+      tick_count_this_frame = max_ticks_per_frame;
+      accumulator_seconds   = tick_seconds * static_cast<float>(max_ticks_per_frame);
+    }
+
+    accumulator_seconds -= tick_seconds * static_cast<float>(tick_count_this_frame);
+    if (accumulator_seconds < 0.0f) accumulator_seconds = 0.0f; // guard against float drift
+
+    tick_count += tick_count_this_frame;
+    return tick_count_this_frame;
+  }
+
+  float interpolation_alpha() const  // how far between the previous and current tick the renderer is [0,1)
+  {
+    float alpha = accumulator_seconds / tick_seconds;
+    return (alpha < 1.0f) ? alpha : 1.0f;
+  }
+
+  float seconds_until_next_tick() const
+  {
+    return tick_seconds - accumulator_seconds;
+  }
+};
+
+inline void interpolate_origin_positions(const sf::Vector2f* const previous_origin_positions, const float* const current_origin_x, const float* const current_origin_y, sf::Vector2f* const interpolated_origin_positions, const int* const ids, const int id_count, const float alpha) // only the given ids (usually gameplay_entities::live_ids) are written
+{
+  for(int id_index=0; id_index < id_count; ++id_index)
+  {
+    int id = ids[id_index];
+    interpolated_origin_positions[id] = previous_origin_positions[id] + ((sf::Vector2f(current_origin_x[id], current_origin_y[id]) - previous_origin_positions[id]) * alpha);
+  }
+}
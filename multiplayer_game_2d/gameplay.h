@@ -1,10 +1,29 @@
 #pragma once
 
-#include <SFML/Graphics.hpp>
+#include <SFML/System/Vector2.hpp>  // header only so the simulation has no graphics/audio/window dependencies
 #include <bitset>
 #include <cmath>
+#include <string.h>
 #include <assert.h>
 #include <limits>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef _DEBUG
+  #include <iostream>
+#endif
+
+// @remember: define GAMEPLAY_DISABLE_SIMD to force the scalar movement kernel (useful for comparing against the vector kernels)
+#if defined(__AVX__) && !defined(GAMEPLAY_DISABLE_SIMD)
+  #include <immintrin.h>
+  #define GAMEPLAY_SIMD_WIDTH 8   // floats per __m256
+#elif ( defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) ) && !defined(GAMEPLAY_DISABLE_SIMD)
+  #include <emmintrin.h>
+  #define GAMEPLAY_SIMD_WIDTH 4   // floats per __m128
+#else
+  #define GAMEPLAY_SIMD_WIDTH 1
+#endif
 
 
 
@@ -28,6 +47,34 @@ struct generate_move_request_input
   }
 };
 
+enum class gameplay_tile_event_type : int
+{
+  ENTER = 0,
+  EXIT  = 1
+};
+
+struct gameplay_tile_event  // emitted by gameplay_entity_moves::update_by_velocities when an entity lands on a tile
+{
+  int gameplay_entity_id = -1;
+  int tile_index         = -1;
+  gameplay_tile_event_type type = gameplay_tile_event_type::ENTER;
+};
+
+#define GAMEPLAY_CHAIN_LENGTH_BUCKETS 8   // chains of 1 to 7 entities, the last bucket counts 8 or more
+
+struct gameplay_move_submit_counters  // what gameplay_entity_moves::submit_all_moves did with the last tick's requests, each request is counted once
+{
+  int requested                = 0;   // live entities with a non-zero move request
+  int ignored_while_moving     = 0;   // requests from entities that are still moving (e.g. a held direction mid-move)
+  int cancelled_by_wall        = 0;   // the chain ran into a wall
+  int cancelled_by_moving      = 0;   // the chain ran into an entity that is moving out of its tile
+  int cancelled_by_destination = 0;   // the chain ran into a tile another entity is moving into
+  int cancelled_by_length      = 0;   // the chain was longer than a row or column (only without border walls)
+  int submitted                = 0;   // requests that started moving
+  int chained                  = 0;   // entities pushed by submitted requests
+  int chain_length_counts[GAMEPLAY_CHAIN_LENGTH_BUCKETS] = {};  // submitted requests by chain length (the requester and everything it pushed), [0] is a lone mover
+};
+
 struct gameplay_entity_move_request
 {
   // implicit entity id
@@ -51,59 +98,139 @@ enum class gameplay_entity_type : int  // these are also the sprite sheet indexe
   BOMB  = 2
 };
 
+struct gameplay_entity_handle  // an entity id tagged with the generation of its slot so stale handles can't alias a reused slot
+{
+  int           id         = -1;
+  std::uint32_t generation = 0;
+
+  bool operator==(const gameplay_entity_handle& other) const { return (id == other.id) && (generation == other.generation); }
+  bool operator!=(const gameplay_entity_handle& other) const { return !(*this == other); }
+};
+
 template<int p_max_size>
 struct gameplay_entities
 {
-  /* @remember: origin is top-left vertex */
+  /* @remember: origin is top-left collision vertex */
+  /* @remember: this is simulation only data, sprites are in gameplay_entity_sprites (gameplay_render.h) */
 
-  sf::Vertex vertex_buffer[p_max_size * 4];           // 4 vertices per entity
-  sf::Texture sprite_sheet_texture;                   // a sprite sheet where each row is a separate entity and each column is a different frame for an animation (the first row is transparent)
   sf::Vector2f collision_vertices[p_max_size * 4];    // 4 vertices per entity [top-left, top-right, bottom-right, bottom-left]
-  const int sprite_sheet_side_length;                 // the pixel length and width of each entity animation frame
   const int max_size = p_max_size;
-  const int vertex_count = p_max_size * 4;            // 4 vertices per entity
+  const int vertex_count = p_max_size * 4;            // 4 collision vertices per entity
 
   gameplay_entity_type types[p_max_size] = {gameplay_entity_type::NONE}; // type of gameplay entity that's also used to specify row in sprite_sheet
   int animation_indexes[p_max_size] = {0};                               // current frame for animation
-  std::bitset<p_max_size> is_garbage_flags;
+  std::bitset<p_max_size> is_garbage_flags;                              // @remember: only spawn() and despawn() should change these
+  std::uint32_t generations[p_max_size] = {0};                           // incremented on despawn so old handles to the slot become invalid
+  int live_ids[p_max_size];                                              // packed ids of live entities, systems iterate [0, live_count) instead of every slot (order changes on despawn)
+  int live_count = 0;
+  int id_bound   = 0;                                                    // one past the highest id spawn() has handed out, every live id is below it (ids are handed out lowest first so this stays close to live_count)
+
+  private:
+    int free_ids[p_max_size];        // stack of garbage slots, top is free_ids[free_id_count - 1]
+    int free_id_count = 0;
+    int free_id_indexes[p_max_size]; // where each garbage id is in free_ids so spawn_with_id can take it in O(1)
+    int live_id_indexes[p_max_size]; // where each live id is in live_ids so despawn can swap-remove in O(1)
+  public:
 
 
-  gameplay_entities(const char* sprite_sheet_texture_file_path, const int p_sprite_sheet_side_length) : sprite_sheet_side_length(p_sprite_sheet_side_length)
+  gameplay_entities()
   {
     static_assert(p_max_size <= std::numeric_limits<int>::max(), "Max gameplay entity count is too big to be represented by int");
 
-    sprite_sheet_texture.loadFromFile(sprite_sheet_texture_file_path);
-
     for(int i=0; i < p_max_size; ++i)
     {
       is_garbage_flags[i] = true;
     }
 
-    // need guarantee default values in case some memory never filled
-    for(auto& vertex : vertex_buffer)
+    // push in reverse so ids are handed out lowest first
+    for(int id=p_max_size - 1; id >= 0; --id)
     {
-      vertex.position  = sf::Vector2f(0.0f, 0.0f);
-      vertex.texCoords = sf::Vector2f(0.0f, 0.0f);
+      free_ids[free_id_count] = id;
+      free_id_indexes[id]     = free_id_count;
+      ++free_id_count;
     }
 
+    // need guarantee default values in case some memory never filled
     for(auto& collision_vertice : collision_vertices)
     {
       collision_vertice = sf::Vector2f(0.0f, 0.0f);
     }
   }
 
-  void set_all_positions(const sf::Vector2f* const all_origin_positions)
+  gameplay_entity_handle spawn(const gameplay_entity_type type, const sf::Vector2f& origin_position, const sf::Vector2f& collision_size)  // returns an invalid handle (id -1) when full
+  {
+    gameplay_entity_handle handle;
+    if (free_id_count == 0) return handle;
+
+    --free_id_count;
+    handle.id         = free_ids[free_id_count];
+    handle.generation = generations[handle.id];
+
+    activate(handle.id, type, origin_position, collision_size);
+    return handle;
+  }
+
+  gameplay_entity_handle spawn_with_id(const int id, const gameplay_entity_type type, const sf::Vector2f& origin_position, const sf::Vector2f& collision_size)  // for mirroring another simulation's ids (e.g. a client replicating server entities), returns an invalid handle if id is live
+  {
+    gameplay_entity_handle handle;
+    if ( (id < 0) || (id >= p_max_size) || !is_garbage_flags[id] ) return handle;
+
+    // move id to the top of the free stack then pop it
+    int top_id = free_ids[free_id_count - 1];
+    free_ids[free_id_indexes[id]] = top_id;
+    free_id_indexes[top_id]       = free_id_indexes[id];
+    --free_id_count;
+
+    handle.id         = id;
+    handle.generation = generations[id];
+
+    activate(id, type, origin_position, collision_size);
+    return handle;
+  }
+
+  bool despawn(const gameplay_entity_handle handle)  // @remember: also call gameplay_entity_moves::remove_entity so the entity stops occupying its tile
+  {
+    if (!is_valid(handle)) return false;
+
+    is_garbage_flags[handle.id] = true;
+    types[handle.id]            = gameplay_entity_type::NONE;
+    ++generations[handle.id];
+
+    // swap-remove from live_ids
+    int last_live_id = live_ids[live_count - 1];
+    live_ids[live_id_indexes[handle.id]] = last_live_id;
+    live_id_indexes[last_live_id]        = live_id_indexes[handle.id];
+    --live_count;
+
+    free_ids[free_id_count]    = handle.id;
+    free_id_indexes[handle.id] = free_id_count;
+    ++free_id_count;
+
+    return true;
+  }
+
+  bool is_valid(const gameplay_entity_handle handle) const
+  {
+    return (handle.id >= 0) && (handle.id < p_max_size) && !is_garbage_flags[handle.id] && (generations[handle.id] == handle.generation);
+  }
+
+  gameplay_entity_handle handle_of(const int gameplay_entity_id) const
+  {
+    gameplay_entity_handle handle;
+    handle.id         = gameplay_entity_id;
+    handle.generation = generations[gameplay_entity_id];
+    return handle;
+  }
+
+  void set_all_positions(const float* const all_origin_x, const float* const all_origin_y)  // origins are separate x/y arrays (see gameplay_entity_moves)
   {
     sf::Vector2f current_position_offset;
 
-    for(int entity_index=0,vertex=0; entity_index < max_size; ++entity_index,vertex += 4)
+    for(int live_index=0; live_index < live_count; ++live_index)
     {
-      current_position_offset = all_origin_positions[entity_index] - collision_vertices[vertex];
-
-      vertex_buffer[vertex].position   += current_position_offset;
-      vertex_buffer[vertex+1].position += current_position_offset;
-      vertex_buffer[vertex+2].position += current_position_offset;
-      vertex_buffer[vertex+3].position += current_position_offset;
+      int entity_index = live_ids[live_index];
+      int vertex       = entity_index * 4;
+      current_position_offset = sf::Vector2f(all_origin_x[entity_index], all_origin_y[entity_index]) - collision_vertices[vertex];
 
       collision_vertices[vertex]   += current_position_offset;
       collision_vertices[vertex+1] += current_position_offset;
@@ -122,29 +249,10 @@ struct gameplay_entities
     return collision_vertices_origin_positions;
   }
 
-  void update_tex_coords(const float elapsed_frame_time_seconds)  // update tex coords based on type and animation index
-  {
-    for(int entity_index=0,vertex=0; entity_index < max_size; ++entity_index,vertex += 4)
-    {
-      float current_sprite_sheet_y_position = (float) (sprite_sheet_texture.getSize().y - sprite_sheet_side_length) - static_cast<int>(types[entity_index]) * sprite_sheet_side_length * !is_garbage_flags[entity_index];
-      float current_sprite_sheet_x_position = (float) animation_indexes[entity_index] * sprite_sheet_side_length * !is_garbage_flags[entity_index];
-
-      vertex_buffer[vertex].texCoords   = sf::Vector2f(current_sprite_sheet_x_position, current_sprite_sheet_y_position);
-      vertex_buffer[vertex+1].texCoords = sf::Vector2f(current_sprite_sheet_x_position + sprite_sheet_side_length, current_sprite_sheet_y_position);
-      vertex_buffer[vertex+2].texCoords = sf::Vector2f(current_sprite_sheet_x_position + sprite_sheet_side_length, current_sprite_sheet_y_position + sprite_sheet_side_length);
-      vertex_buffer[vertex+3].texCoords = sf::Vector2f(current_sprite_sheet_x_position, current_sprite_sheet_y_position + sprite_sheet_side_length);
-    }
-  }
-
   void update_position_by_offset(const int gameplay_entity_id, const sf::Vector2f& offset)
   {
     int vertex = gameplay_entity_id * 4;
 
-    vertex_buffer[vertex].position   += offset;
-    vertex_buffer[vertex+1].position += offset;
-    vertex_buffer[vertex+2].position += offset;
-    vertex_buffer[vertex+3].position += offset;
-
     collision_vertices[vertex]   += offset;
     collision_vertices[vertex+1] += offset;
     collision_vertices[vertex+2] += offset;
@@ -167,283 +275,311 @@ struct gameplay_entities
     }
   }
 
-  #ifdef _DEBUG
-    #include <string.h>
-
-    sf::VertexArray* generate_debug_collision_line_vertices(const sf::Color color) const
-    {
-      static int debug_collision_line_vertex_count = p_max_size * 8; // 4 lines per entity and 2 vertices per line so 8 vertices per entity
-      static sf::VertexArray debug_collision_line_vertices(sf::Lines, debug_collision_line_vertex_count);
-
-      debug_collision_line_vertices.clear();
-      debug_collision_line_vertices.resize(debug_collision_line_vertex_count);
+    private:
+      sf::Vector2f collision_vertices_origin_positions[p_max_size];
 
-      for(size_t i=0,entity_vertex=0; i < debug_collision_line_vertex_count; i+=8,entity_vertex+=4)
+      void activate(const int id, const gameplay_entity_type type, const sf::Vector2f& origin_position, const sf::Vector2f& collision_size)  // id must already be off the free stack
       {
-        size_t current_entity_id = entity_vertex / 4;
-        if(is_garbage_flags[current_entity_id] == true) continue;
-
-        debug_collision_line_vertices[i].position   = this->collision_vertices[entity_vertex];
-        debug_collision_line_vertices[i+1].position = this->collision_vertices[entity_vertex+1];
-        debug_collision_line_vertices[i].color      = color;
-        debug_collision_line_vertices[i+1].color    = color;
-
-        debug_collision_line_vertices[i+2].position = this->collision_vertices[entity_vertex+1];
-        debug_collision_line_vertices[i+3].position = this->collision_vertices[entity_vertex+2];
-        debug_collision_line_vertices[i+2].color    = color;
-        debug_collision_line_vertices[i+3].color    = color;
-
-        debug_collision_line_vertices[i+4].position = this->collision_vertices[entity_vertex+2];
-        debug_collision_line_vertices[i+5].position = this->collision_vertices[entity_vertex+3];
-        debug_collision_line_vertices[i+4].color    = color;
-        debug_collision_line_vertices[i+5].color    = color;
-
-        debug_collision_line_vertices[i+6].position = this->collision_vertices[entity_vertex+3];
-        debug_collision_line_vertices[i+7].position = this->collision_vertices[entity_vertex];
-        debug_collision_line_vertices[i+6].color    = color;
-        debug_collision_line_vertices[i+7].color    = color;
+        is_garbage_flags[id]  = false;
+        types[id]             = type;
+        animation_indexes[id] = 0;
+
+        live_ids[live_count] = id;
+        live_id_indexes[id]  = live_count;
+        ++live_count;
+        if (id >= id_bound) id_bound = id + 1;
+
+        int vertex = id * 4;
+        collision_vertices[vertex]   = origin_position;
+        collision_vertices[vertex+1] = origin_position + sf::Vector2f(collision_size.x, 0.0f);
+        collision_vertices[vertex+2] = origin_position + collision_size;
+        collision_vertices[vertex+3] = origin_position + sf::Vector2f(0.0f, collision_size.y);
       }
+};
 
-      return &debug_collision_line_vertices;
-    }
 
-    sf::VertexArray* generate_debug_line_vertices(const sf::Color color) const
-    {
-      static int debug_line_vertex_count = max_size * 8; // 4 lines per entity and 2 vertices per line so 8 vertices per entity
-      static sf::VertexArray debug_line_vertices(sf::Lines, debug_line_vertex_count);
 
-      debug_line_vertices.clear();
-      debug_line_vertices.resize(debug_line_vertex_count);
+/* tile_map stuff */
+enum class tile_map_bitmap_type : int // these are also the sprite sheet indexes
+{
+  NONE = 0,
+  BLAH = 1,
+  TEST = 2,
+  TEMP = 3,
+  WALL = 4
+};
 
-      for(size_t i=0,entity_vertex=0; i < debug_line_vertex_count; i+=8,entity_vertex+=4)
-      {
-        size_t current_entity_id = entity_vertex / 4;
-        if(is_garbage_flags[current_entity_id] == true) continue;
-
-        debug_line_vertices[i].position   = this->vertex_buffer[entity_vertex].position;
-        debug_line_vertices[i+1].position = this->vertex_buffer[entity_vertex+1].position;
-        debug_line_vertices[i].color      = color;
-        debug_line_vertices[i+1].color    = color;
-
-        debug_line_vertices[i+2].position = this->vertex_buffer[entity_vertex+1].position;
-        debug_line_vertices[i+3].position = this->vertex_buffer[entity_vertex+2].position;
-        debug_line_vertices[i+2].color    = color;
-        debug_line_vertices[i+3].color    = color;
-
-        debug_line_vertices[i+4].position = this->vertex_buffer[entity_vertex+2].position;
-        debug_line_vertices[i+5].position = this->vertex_buffer[entity_vertex+3].position;
-        debug_line_vertices[i+4].color    = color;
-        debug_line_vertices[i+5].color    = color;
-
-        debug_line_vertices[i+6].position = this->vertex_buffer[entity_vertex+3].position;
-        debug_line_vertices[i+7].position = this->vertex_buffer[entity_vertex].position;
-        debug_line_vertices[i+6].color    = color;
-        debug_line_vertices[i+7].color    = color;
-      }
+#define RUNTIME_TILE_MAP_SIZE 0   // tile_map<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE> gets its width and height at runtime
 
-      return &debug_line_vertices;
-    }
+template<typename t_value, int p_count>
+struct tile_array  // compile-time sized storage for per tile data
+{
+  static constexpr int count = p_count;
+  t_value values[p_count];
 
-    void generate_debug_index_text(sf::Text (&debug_entity_index_text)[p_max_size], const sf::Font& font, const sf::Color color) const
-    {
-      for(auto& text : debug_entity_index_text) text.setString("");
+  explicit tile_array(const int) {}
 
-      for(int entity_index=0; entity_index < p_max_size; ++entity_index)
-      {
-        if ( this->is_garbage_flags[entity_index] ) continue;
+  t_value&       operator[](const int index)       { return values[index]; }
+  const t_value& operator[](const int index) const { return values[index]; }
+  t_value*       data()                            { return values; }
+  const t_value* data()                      const { return values; }
+};
 
-        int character_size = static_cast<int>( this->collision_vertices[(entity_index * 4) + 1].x - this->collision_vertices[entity_index * 4].x ) / 4;
+template<typename t_value>
+struct tile_array<t_value, RUNTIME_TILE_MAP_SIZE>  // runtime sized storage for per tile data
+{
+  const int count;
+  std::unique_ptr<t_value[]> values;
 
-        debug_entity_index_text[entity_index].setFont(font);
-        debug_entity_index_text[entity_index].setString(std::to_string(entity_index));
-        debug_entity_index_text[entity_index].setFillColor(color);
-        debug_entity_index_text[entity_index].setStyle(sf::Text::Bold);
-        debug_entity_index_text[entity_index].setCharacterSize(character_size);
-        debug_entity_index_text[entity_index].setPosition( this->collision_vertices[entity_index * 4] );
-      }
-    }
-  #endif
+  explicit tile_array(const int p_count) : count(p_count), values(new t_value[p_count]) {}
 
-    private:
-      sf::Vector2f collision_vertices_origin_positions[p_max_size];
+  t_value&       operator[](const int index)       { return values[index]; }
+  const t_value& operator[](const int index) const { return values[index]; }
+  t_value*       data()                            { return values.get(); }
+  const t_value* data()                      const { return values.get(); }
 };
 
+template<int p_width, int p_height>
+struct tile_map_dimensions  // known at compile time so index math folds to constants (and shifts for power of two widths) and loops can unroll
+{
+  static_assert( (p_width > 0) && (p_height > 0), "Use RUNTIME_TILE_MAP_SIZE for both tile_map dimensions for a runtime sized tile_map" );
 
+  static constexpr int width      = p_width;
+  static constexpr int height     = p_height;
+  static constexpr int tile_count = p_width * p_height;
 
-/* tile_map stuff */
-enum class tile_map_bitmap_type : int // these are also the sprite sheet indexes
+  tile_map_dimensions(const int p_runtime_width, const int p_runtime_height)
+  {
+    assert( (p_runtime_width == p_width) && (p_runtime_height == p_height) );
+  }
+};
+
+template<int p_width, int p_height> constexpr int tile_map_dimensions<p_width,p_height>::width;
+template<int p_width, int p_height> constexpr int tile_map_dimensions<p_width,p_height>::height;
+template<int p_width, int p_height> constexpr int tile_map_dimensions<p_width,p_height>::tile_count;
+
+template<>
+struct tile_map_dimensions<RUNTIME_TILE_MAP_SIZE, RUNTIME_TILE_MAP_SIZE>
 {
-  NONE = 0,
-  BLAH = 1,
-  TEST = 2,
-  TEMP = 3,
-  WALL = 4
+  const int width;
+  const int height;
+  const int tile_count;
+
+  tile_map_dimensions(const int p_runtime_width, const int p_runtime_height) : width(p_runtime_width), height(p_runtime_height), tile_count(p_runtime_width * p_runtime_height)
+  {
+    assert( (p_runtime_width > 0) && (p_runtime_height > 0) );
+    assert( p_runtime_width <= (std::numeric_limits<int>::max() / p_runtime_height) );
+  }
 };
 
 template<int p_width, int p_height>
-struct tile_map
+struct tile_map : tile_map_dimensions<p_width, p_height>
 {
-  // @remember: first 4 vertices in tile_map vertex buffer are for background tile
+  /* @remember: this is simulation only data, tile vertices and texture are in tile_map_sprites (gameplay_render.h) */
+  /* @remember: use tile_map<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE> for map sizes that aren't known at compile time, common arena sizes should stay compile-time for the fast path */
+
+  using tile_map_dimensions<p_width, p_height>::width;
+  using tile_map_dimensions<p_width, p_height>::height;
+  using tile_map_dimensions<p_width, p_height>::tile_count;
 
-  const int width = p_width;
-  const int height = p_height;
-  const int tile_count = p_width * p_height;
   const float tile_size_x;
   const float tile_size_y;
-  const int vertex_count = (p_width * p_height * 4) + 4;    // (4 vertices per tile) + 4 vertices for background
-  sf::Texture tiles_texture;                                // a tile sheet of tile_sheet_side_length x tile_sheet_side_length sized tiles where the first tile is the default background
-  sf::Vertex vertex_buffer[(p_width * p_height * 4) + 4];   // (4 vertices per tile) + 4 vertices for background
-  int bitmap[p_width * p_height] = {0};
-  const int tile_sheet_side_length;                         // pixel width and height for a tile in tile sheet
-
-  tile_map(const char* tiles_texture_file_path, const float window_size_x, const float window_size_y, const int p_tile_side_length) : tile_size_x(window_size_x / width),tile_size_y(window_size_y / height), tile_sheet_side_length(p_tile_side_length)
-  {
-    static_assert( (p_width * p_height) <= std::numeric_limits<int>::max(), "Max tile count is too big to be represented by int" );
-
-    tiles_texture.loadFromFile(tiles_texture_file_path);
-
-    // assign screen coordinates and texture coordinates for background
-    this->vertex_buffer[0].position  = sf::Vector2f(0.0f, 0.0f);
-    this->vertex_buffer[0].texCoords = sf::Vector2f(0.0f , 0.0f);
-    this->vertex_buffer[1].position  = sf::Vector2f(tile_size_x * width, 0);
-    this->vertex_buffer[1].texCoords = sf::Vector2f((float) tile_sheet_side_length, 0.0f);
-    this->vertex_buffer[2].position  = sf::Vector2f(tile_size_x * width, tile_size_y * height);
-    this->vertex_buffer[2].texCoords = sf::Vector2f((float) tile_sheet_side_length, (float) tile_sheet_side_length);
-    this->vertex_buffer[3].position  = sf::Vector2f(0.0f, tile_size_y * height);
-    this->vertex_buffer[3].texCoords = sf::Vector2f(0.0f, (float) tile_sheet_side_length);
-
-    // assign screen coordinates for each vertex in tiles
-    for(int y=0,vertex=4; y < height; ++y)
-    for(int x=0         ; x < width ; ++x, vertex+=4)
-    {
-      this->vertex_buffer[vertex].position   = sf::Vector2f(x * tile_size_x    , y * tile_size_y);
-      this->vertex_buffer[vertex+1].position = sf::Vector2f((x+1) * tile_size_x, y * tile_size_y);
-      this->vertex_buffer[vertex+2].position = sf::Vector2f((x+1) * tile_size_x, (y+1) * tile_size_y);
-      this->vertex_buffer[vertex+3].position = sf::Vector2f(x * tile_size_x    , (y+1) * tile_size_y);
-    }
-  }
+  tile_array<int, p_width * p_height> bitmap;
 
-  void update_tex_coords_from_bitmap()
+  tile_map(const float world_size_x, const float world_size_y) : tile_map(p_width, p_height, world_size_x, world_size_y) {}
+
+  tile_map(const int p_runtime_width, const int p_runtime_height, const float world_size_x, const float world_size_y) : tile_map_dimensions<p_width, p_height>(p_runtime_width, p_runtime_height),
+                                                                                                                        tile_size_x(world_size_x / p_runtime_width),tile_size_y(world_size_y / p_runtime_height),
+                                                                                                                        bitmap(p_runtime_width * p_runtime_height)
   {
-    for(int tile=0, vertex=4,texture_offset; tile < tile_count; ++tile, vertex+=4)
-    {
-      texture_offset = bitmap[tile] * tile_sheet_side_length;
+    static_assert( (static_cast<long long>(p_width) * p_height) <= std::numeric_limits<int>::max(), "Max tile count is too big to be represented by int" );
 
-      this->vertex_buffer[vertex].texCoords   = sf::Vector2f((float) texture_offset                         , 0.0f);
-      this->vertex_buffer[vertex+1].texCoords = sf::Vector2f((float) texture_offset + tile_sheet_side_length, 0.0f);
-      this->vertex_buffer[vertex+2].texCoords = sf::Vector2f((float) texture_offset + tile_sheet_side_length, (float) tile_sheet_side_length);
-      this->vertex_buffer[vertex+3].texCoords = sf::Vector2f((float) texture_offset                         , (float) tile_sheet_side_length);
-    }
+    for(int tile=0; tile < tile_count; ++tile) bitmap[tile] = 0;
   }
 
   int calculate_tile_map_index(const sf::Vector2f collision_vertex) const
   {
     int y_index = static_cast<int>(collision_vertex.y / tile_size_y);
     int x_index = static_cast<int>(collision_vertex.x / tile_size_x);
-    return (y_index * p_width) + x_index;
+    return (y_index * width) + x_index;
   }
 
-  #ifdef _DEBUG
-    #include <string.h>
+};
 
-    sf::VertexArray* generate_debug_line_vertices(const sf::Color color) const
-    {
-      static int debug_lines_vertex_count = ((p_width * p_height) + 1) * 8; // 4 lines per tile and 2 vertices per line so 8 vertices per tile, the additional 1 is for background tile
-      static sf::VertexArray debug_line_vertices(sf::Lines, debug_lines_vertex_count);
 
-      for(size_t i=0,tile_map_vertex=0; i < debug_lines_vertex_count; i+=8,tile_map_vertex+=4)
-      {
-        debug_line_vertices[i].position   = this->vertex_buffer[tile_map_vertex].position;
-        debug_line_vertices[i+1].position = this->vertex_buffer[tile_map_vertex+1].position;
-        debug_line_vertices[i].color      = color;
-        debug_line_vertices[i+1].color    = color;
-
-        debug_line_vertices[i+2].position = this->vertex_buffer[tile_map_vertex+1].position;
-        debug_line_vertices[i+3].position = this->vertex_buffer[tile_map_vertex+2].position;
-        debug_line_vertices[i+2].color    = color;
-        debug_line_vertices[i+3].color    = color;
-
-        debug_line_vertices[i+4].position = this->vertex_buffer[tile_map_vertex+2].position;
-        debug_line_vertices[i+5].position = this->vertex_buffer[tile_map_vertex+3].position;
-        debug_line_vertices[i+4].color    = color;
-        debug_line_vertices[i+5].color    = color;
-
-        debug_line_vertices[i+6].position = this->vertex_buffer[tile_map_vertex+3].position;
-        debug_line_vertices[i+7].position = this->vertex_buffer[tile_map_vertex].position;
-        debug_line_vertices[i+6].color    = color;
-        debug_line_vertices[i+7].color    = color;
-      }
 
-      return &debug_line_vertices;
-    }
+/* collision stuff */
+struct gameplay_entity_id_span  // the ids in one tile bucket, valid until the bucket is next changed
+{
+  const int* ids = nullptr;
+  int count      = 0;
 
-    void generate_debug_tile_index_text(sf::Text(&debug_tile_index_text)[p_width * p_height], const sf::Font& font, const sf::Color color) const
-    {
-      static int character_size = static_cast<int>(tile_size_x) / 4;
+  const int* begin() const { return ids; }
+  const int* end() const   { return ids + count; }
+};
 
-      for(int i=0, tile_index=1; i < tile_count; ++tile_index, ++i)
-      {
-        debug_tile_index_text[i].setFont(font);
-        debug_tile_index_text[i].setString(std::to_string(i));
-        debug_tile_index_text[i].setFillColor(color);
-        debug_tile_index_text[i].setStyle(sf::Text::Bold);
-        debug_tile_index_text[i].setCharacterSize(character_size);
-        debug_tile_index_text[i].setPosition( this->vertex_buffer[tile_index * 4].position );
-      }
-    }
-  #endif
+template<int p_tile_map_width, int p_tile_map_height, int p_max_gameplay_entities>
+inline int calculate_entity_tile_indexes(const int id, const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map, const gameplay_entities<p_max_gameplay_entities>& p_game_entities, int* const tile_indexes)  // writes up to 4 tile indexes, returns how many distinct tiles the collision vertices are in
+{
+  int entry_count = 0;
 
-};
+  for(int current_collision_vertex = id * 4, last_collision_vertex = current_collision_vertex + 3; current_collision_vertex <= last_collision_vertex; ++current_collision_vertex)
+  {
+    int current_y_index = static_cast<int>(p_game_entities.collision_vertices[current_collision_vertex].y / p_tile_map.tile_size_y);
+    int current_x_index = static_cast<int>(p_game_entities.collision_vertices[current_collision_vertex].x / p_tile_map.tile_size_x);
 
+    int current_tile_index = (current_y_index * p_tile_map.width) + current_x_index;
 
+    bool is_duplicate = false;
+    for(int entry=0; entry < entry_count; ++entry) is_duplicate |= (tile_indexes[entry] == current_tile_index);
+    if (is_duplicate) continue;
+
+    tile_indexes[entry_count] = current_tile_index;
+    ++entry_count;
+  }
+
+  return entry_count;
+}
 
-/* collision stuff */
 template<int p_tile_map_width, int p_tile_map_height, int p_max_gameplay_entities, int p_max_entities_per_tile>
 struct gameplay_entity_ids_per_tile
 {
   /*
      @remember: the second vertex in tile is not considered overlapping the first vertex in the next tile; the same goes for the 3rd vertex of a tile not sharing position of the 4th vertex of the next tile
      @remember:     ex) if the position of a gameplay vertex is same position as top-left vertex in tile, it is considered in that tile and not also in the previous tile
+     @remember: each bucket is packed (ids first, then -1) so removal is a swap with the last id in the bucket
+     @remember: update() rebuilds every bucket, update_moved_entities() only re-bins the entities the movement system moved and only touches buckets when a corner changes tile
   */
 
-  int tile_buckets[p_max_entities_per_tile * p_max_gameplay_entities];
+  tile_array<int, p_max_entities_per_tile * p_tile_map_width * p_tile_map_height> tile_buckets;  // p_max_entities_per_tile slots per tile
+  tile_array<int, p_tile_map_width * p_tile_map_height> tile_bucket_counts;                      // how many slots of each bucket are used
+  long long dropped_entry_count = 0;                                                             // entity entries add_entity couldn't place because their tile's bucket was full
+
+  private:
+    int entity_tile_indexes[p_max_gameplay_entities * 4];   // the distinct tiles each entity is binned in (up to 4, unused are -1)
+    int entity_bucket_indexes[p_max_gameplay_entities * 4]; // the tile_buckets index for each entry of entity_tile_indexes
+  public:
 
-  gameplay_entity_ids_per_tile()
+  gameplay_entity_ids_per_tile(const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map) : tile_buckets(p_max_entities_per_tile * p_tile_map.tile_count), tile_bucket_counts(p_tile_map.tile_count)
   {
-    memset(tile_buckets, -1, sizeof(tile_buckets));
+    memset(tile_buckets.data(), -1, sizeof(int) * tile_buckets.count);
+    memset(tile_bucket_counts.data(), 0, sizeof(int) * tile_bucket_counts.count);
+    memset(entity_tile_indexes, -1, sizeof(entity_tile_indexes));
+    memset(entity_bucket_indexes, -1, sizeof(entity_bucket_indexes));
   }
 
-  void update(const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map, const gameplay_entities<p_max_gameplay_entities>& p_game_entities)
+  void update(const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map, const gameplay_entities<p_max_gameplay_entities>& p_game_entities)  // full rebuild
+  {
+    memset(tile_buckets.data(), -1, sizeof(int) * tile_buckets.count);
+    memset(tile_bucket_counts.data(), 0, sizeof(int) * tile_bucket_counts.count);
+
+    for(int live_index=0; live_index < p_game_entities.live_count; ++live_index)
+    {
+      add_entity(p_game_entities.live_ids[live_index], p_tile_map, p_game_entities);
+    }
+  }
+
+  void update_moved_entities(const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map, const gameplay_entities<p_max_gameplay_entities>& p_game_entities, const int* const moved_ids, const int moved_count)  // call after set_all_positions with gameplay_entity_moves::moved_ids
+  {
+    int tile_indexes[4];
+
+    for(int moved_index=0; moved_index < moved_count; ++moved_index)
+    {
+      int id          = moved_ids[moved_index];
+      int entry_count = calculate_entity_tile_indexes(id, p_tile_map, p_game_entities, tile_indexes);
+
+      // nothing to do if every corner is still in the same tile (the usual case)
+      bool has_changed_tile = false;
+      for(int entry=0; entry < 4; ++entry)
+      {
+        has_changed_tile |= ( ((entry < entry_count) ? tile_indexes[entry] : -1) != entity_tile_indexes[(id * 4) + entry] );
+      }
+      if (!has_changed_tile) continue;
+
+      remove_entity(id);
+      add_entity(id, p_tile_map, p_game_entities);
+    }
+  }
+
+  void add_entity(const int id, const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map, const gameplay_entities<p_max_gameplay_entities>& p_game_entities)  // call after gameplay_entities::spawn
   {
-    memset(tile_buckets, -1, sizeof(tile_buckets));
+    int tile_indexes[4];
+    int entry_count = calculate_entity_tile_indexes(id, p_tile_map, p_game_entities, tile_indexes);
+    int added_count = 0;
 
-    for(int current_collision_vertex=0; current_collision_vertex < p_game_entities.vertex_count; ++current_collision_vertex) // vertex_count is same as collision_vertex_count
+    for(int entry=0; entry < entry_count; ++entry)
     {
-      int current_gameplay_entity_id = current_collision_vertex / 4;
-      if (p_game_entities.is_garbage_flags[current_gameplay_entity_id]) continue;
+      int tile_index = tile_indexes[entry];
 
-      int current_y_index = static_cast<int>(p_game_entities.collision_vertices[current_collision_vertex].y / p_tile_map.tile_size_y);
-      int current_x_index = static_cast<int>(p_game_entities.collision_vertices[current_collision_vertex].x / p_tile_map.tile_size_x);
+      // @remember: an entity is dropped from a full bucket instead of writing into the next tile's bucket, in every build (see dropped_entry_count)
+      if (tile_bucket_counts[tile_index] == p_max_entities_per_tile)
+      {
+        ++dropped_entry_count;
+        continue;
+      }
 
-      int current_tile_index = (current_y_index * p_tile_map.width) + current_x_index;
-      int current_tile_bucket_index = current_tile_index * p_max_entities_per_tile;
-      int current_max_tile_bucket_index_limit = current_tile_bucket_index + p_max_entities_per_tile;
+      int bucket_index = (tile_index * p_max_entities_per_tile) + tile_bucket_counts[tile_index];
+      ++tile_bucket_counts[tile_index];
+      tile_buckets[bucket_index] = id;
 
-      // find open tile_bucket for current_tile_index
-      for(; ( current_tile_bucket_index < current_max_tile_bucket_index_limit )     &&
-            (tile_buckets[current_tile_bucket_index] != -1)                         &&
-            (tile_buckets[current_tile_bucket_index] != current_gameplay_entity_id); ++current_tile_bucket_index
-         ) {};
+      entity_tile_indexes[(id * 4) + added_count]   = tile_index;
+      entity_bucket_indexes[(id * 4) + added_count] = bucket_index;
+      ++added_count;
+    }
 
-      tile_buckets[current_tile_bucket_index] = current_gameplay_entity_id;
+    for(; added_count < 4; ++added_count)
+    {
+      entity_tile_indexes[(id * 4) + added_count]   = -1;
+      entity_bucket_indexes[(id * 4) + added_count] = -1;
+    }
+  }
+
+  void remove_entity(const int id)  // call with gameplay_entities::despawn
+  {
+    for(int entry=(id * 4), last_entry=(id * 4) + 3; (entry <= last_entry) && (entity_tile_indexes[entry] != -1); ++entry)
+    {
+      int tile_index        = entity_tile_indexes[entry];
+      int bucket_index      = entity_bucket_indexes[entry];
+      int last_bucket_index = (tile_index * p_max_entities_per_tile) + tile_bucket_counts[tile_index] - 1;
+
+      // swap the last id in the bucket into the removed slot
+      int last_id = tile_buckets[last_bucket_index];
+      tile_buckets[bucket_index]      = last_id;
+      tile_buckets[last_bucket_index] = -1;
+      --tile_bucket_counts[tile_index];
+
+      for(int last_id_entry=(last_id * 4); last_id_entry < (last_id * 4) + 4; ++last_id_entry)
+      {
+        if (entity_tile_indexes[last_id_entry] == tile_index) entity_bucket_indexes[last_id_entry] = bucket_index;
+      }
+
+      entity_tile_indexes[entry]   = -1;
+      entity_bucket_indexes[entry] = -1;
+    }
+  }
+
+  void count_bucket_occupancy(long long* const tile_counts, const int bucket_count) const  // tile_counts[n] += tiles holding n entities, the last bucket also counts fuller tiles
+  {
+    for(int tile_index=0; tile_index < tile_bucket_counts.count; ++tile_index)
+    {
+      int occupancy = tile_bucket_counts[tile_index];
+      ++tile_counts[ (occupancy < bucket_count) ? occupancy : (bucket_count - 1) ];
     }
   }
 
+  gameplay_entity_id_span bucket(const int tile_index) const
+  {
+    gameplay_entity_id_span span;
+    span.ids   = &tile_buckets[tile_index * p_max_entities_per_tile];
+    span.count = tile_bucket_counts[tile_index];
+    return span;
+  }
+
   #ifdef _DEBUG
     inline void print_tile_buckets()
     {
       std::cout << "\n";
-      for(int i=0; i < p_max_entities_per_tile * p_max_gameplay_entities; i+= p_max_entities_per_tile)
+      for(int i=0; i < tile_buckets.count; i+= p_max_entities_per_tile)
       {
         std::cout << "Tile index: " << i/p_max_entities_per_tile  << std::endl;
 
@@ -459,66 +595,165 @@ struct gameplay_entity_ids_per_tile
 
 }; // gameplay_entity_ids_per_tile
 
+template<int p_tile_map_width, int p_tile_map_height, int p_max_gameplay_entities>
+struct gameplay_entity_ids_per_tile_compact
+{
+  /*
+     @remember: alternative to gameplay_entity_ids_per_tile that is rebuilt every tick with a counting sort: tile_offsets[tile] to tile_offsets[tile + 1] is the range of packed_entity_ids in that tile
+     @remember: memory is O(tiles + entities) and a bucket can hold any number of entities so dense piles never overflow
+     @remember: ids in a bucket are in live_ids order
+  */
+
+  tile_array<int, (p_tile_map_width * p_tile_map_height) ? ((p_tile_map_width * p_tile_map_height) + 1) : RUNTIME_TILE_MAP_SIZE> tile_offsets;  // 1 extra so the last tile has an end offset
+  int packed_entity_ids[p_max_gameplay_entities * 4];                                                                                         // an entity is in up to 4 tiles
+
+  private:
+    int entity_tile_indexes[p_max_gameplay_entities * 4];  // scratch for update(), the distinct tiles of each live entity in live_ids order
+    int entity_tile_counts[p_max_gameplay_entities];       // scratch for update(), how many entity_tile_indexes each live entity has
+  public:
+
+  gameplay_entity_ids_per_tile_compact(const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map) : tile_offsets(p_tile_map.tile_count + 1)
+  {
+    memset(tile_offsets.data(), 0, sizeof(int) * tile_offsets.count);
+  }
+
+  void update(const tile_map<p_tile_map_width, p_tile_map_height>& p_tile_map, const gameplay_entities<p_max_gameplay_entities>& p_game_entities)
+  {
+    memset(tile_offsets.data(), 0, sizeof(int) * tile_offsets.count);
+
+    // count entities per tile (counted one slot ahead so the prefix sum leaves the start offsets)
+    for(int live_index=0; live_index < p_game_entities.live_count; ++live_index)
+    {
+      int* const tile_indexes = &entity_tile_indexes[live_index * 4];
+      entity_tile_counts[live_index] = calculate_entity_tile_indexes(p_game_entities.live_ids[live_index], p_tile_map, p_game_entities, tile_indexes);
+
+      for(int entry=0; entry < entity_tile_counts[live_index]; ++entry) ++tile_offsets[tile_indexes[entry] + 1];
+    }
+
+    for(int tile_index=1; tile_index < tile_offsets.count; ++tile_index) tile_offsets[tile_index] += tile_offsets[tile_index - 1];
+
+    // scatter ids using tile_offsets as write cursors, then shift the cursors back to the start offsets
+    for(int live_index=0; live_index < p_game_entities.live_count; ++live_index)
+    {
+      for(int entry=0; entry < entity_tile_counts[live_index]; ++entry)
+      {
+        int tile_index = entity_tile_indexes[(live_index * 4) + entry];
+        packed_entity_ids[tile_offsets[tile_index]] = p_game_entities.live_ids[live_index];
+        ++tile_offsets[tile_index];
+      }
+    }
+
+    for(int tile_index=tile_offsets.count - 1; tile_index > 0; --tile_index) tile_offsets[tile_index] = tile_offsets[tile_index - 1];
+    tile_offsets[0] = 0;
+  }
+
+  gameplay_entity_id_span bucket(const int tile_index) const
+  {
+    gameplay_entity_id_span span;
+    span.ids   = packed_entity_ids + tile_offsets[tile_index];
+    span.count = tile_offsets[tile_index + 1] - tile_offsets[tile_index];
+    return span;
+  }
+
+}; // gameplay_entity_ids_per_tile_compact
+
 
 
 /* movement stuff */
 template<int max_entity_count, int tile_map_width, int tile_map_height>
 struct gameplay_entity_moves
 {
-  sf::Vector2f current_origin_positions[max_entity_count];
-  sf::Vector2f destination_origin_positions[max_entity_count];
-  sf::Vector2f velocities[max_entity_count];
+  /*
+     @remember: positions, destinations and velocities are stored as separate x/y float arrays so update_by_velocities can step GAMEPLAY_SIMD_WIDTH entities per instruction
+     @remember: arrays are padded to a multiple of GAMEPLAY_SIMD_WIDTH and every slot that isn't moving has 0 velocity, so the vector kernel can step whole blocks without masking
+  */
+
+  static constexpr int padded_count = ((max_entity_count + GAMEPLAY_SIMD_WIDTH - 1) / GAMEPLAY_SIMD_WIDTH) * GAMEPLAY_SIMD_WIDTH;
+
+  float current_origin_x[padded_count];
+  float current_origin_y[padded_count];
+  float destination_origin_x[padded_count];
+  float destination_origin_y[padded_count];
+  float velocity_x[padded_count];
+  float velocity_y[padded_count];
+  int moved_ids[padded_count];  // ids that moved during the last update_by_velocities (arrivals included), lets gameplay_entity_ids_per_tile::update_moved_entities skip everything else
+  int moved_count   = 0;
+  int arrived_count = 0;         // ids that reached their destination during the last update_by_velocities
+  gameplay_move_submit_counters submit_counters;  // from the last submit_all_moves
+  gameplay_tile_event tile_events[padded_count * 2];  // an EXIT of the previous tile then an ENTER of the new tile for each arrival during the last update_by_velocities
+  int tile_event_count = 0;
 
   private:
-    int tile_index_to_current_entity_id[tile_map_width * tile_map_height];      // the entity id with its origin located in specified tile
-    int tile_index_to_destination_entity_id[tile_map_width * tile_map_height];  // the entity id with its destination_origin in specified tile (its currently moving into specified tile)
+    tile_array<int, tile_map_width * tile_map_height> tile_index_to_current_entity_id;      // the entity id with its origin located in specified tile
+    tile_array<int, tile_map_width * tile_map_height> tile_index_to_destination_entity_id;  // the entity id with its destination_origin in specified tile (its currently moving into specified tile)
+    tile_array<int, (tile_map_width > tile_map_height) ? tile_map_width : tile_map_height> chain_entity_ids;  // scratch for submit_all_moves, a chain can't be longer than a row or column
+    int arrived_ids[padded_count];                                                          // scratch for update_by_velocities, compacted ids that reached their destination this tick
   public:
 
-  gameplay_entity_moves(const sf::Vector2f* const all_origin_positions, const std::bitset<max_entity_count>& is_garbage_flags, const tile_map<tile_map_width,tile_map_height>& p_tile_map)
+  gameplay_entity_moves(const sf::Vector2f* const all_origin_positions, const std::bitset<max_entity_count>& is_garbage_flags, const tile_map<tile_map_width,tile_map_height>& p_tile_map) : tile_index_to_current_entity_id(p_tile_map.tile_count),
+                                                                                                                                                                                         tile_index_to_destination_entity_id(p_tile_map.tile_count),
+                                                                                                                                                                                         chain_entity_ids((p_tile_map.width > p_tile_map.height) ? p_tile_map.width : p_tile_map.height)
   {
-    static_assert(tile_map_width >= tile_map_height, "tile_map height is larger than width must change chain_entity_ids_size");
+    memset(tile_index_to_current_entity_id.data(), -1, sizeof(int) * tile_index_to_current_entity_id.count);
+    memset(tile_index_to_destination_entity_id.data(), -1, sizeof(int) * tile_index_to_destination_entity_id.count);
 
-    memset(tile_index_to_current_entity_id, -1, sizeof(tile_index_to_current_entity_id));
-    memset(tile_index_to_destination_entity_id, -1, sizeof(tile_index_to_destination_entity_id));
+    // need guarantee default values in case some memory never filled (including the padding)
+    for(int id=0; id < padded_count; ++id)
+    {
+      current_origin_x[id]     = 0.0f;
+      current_origin_y[id]     = 0.0f;
+      destination_origin_x[id] = 0.0f;
+      destination_origin_y[id] = 0.0f;
+      velocity_x[id]           = 0.0f;
+      velocity_y[id]           = 0.0f;
+    }
 
     for(int id=0; id < max_entity_count; ++id)
     {
       if (is_garbage_flags[id]) continue;
       tile_index_to_current_entity_id[p_tile_map.calculate_tile_map_index(all_origin_positions[id])] = id;
-      current_origin_positions[id] = all_origin_positions[id];
+      current_origin_x[id] = all_origin_positions[id].x;
+      current_origin_y[id] = all_origin_positions[id].y;
     }
-
-    for(auto& position : destination_origin_positions) position = sf::Vector2f(0.0f, 0.0f);
-    for(auto& velocity : velocities) velocity                   = sf::Vector2f(0.0f, 0.0f);
   }
 
-  void submit_all_moves(gameplay_entity_move_request* const all_move_requests, const tile_map<tile_map_width,tile_map_height>& p_tile_map, const std::bitset<max_entity_count>& is_garbage_flags)
+  sf::Vector2f current_origin_position(const int id) const     { return sf::Vector2f(current_origin_x[id], current_origin_y[id]); }
+  sf::Vector2f destination_origin_position(const int id) const { return sf::Vector2f(destination_origin_x[id], destination_origin_y[id]); }
+  sf::Vector2f velocity(const int id) const                    { return sf::Vector2f(velocity_x[id], velocity_y[id]); }
+  bool is_moving(const int id) const                           { return velocity_x[id] || velocity_y[id]; }
+
+  void submit_all_moves(gameplay_entity_move_request* const all_move_requests, const tile_map<tile_map_width,tile_map_height>& p_tile_map, const gameplay_entities<max_entity_count>& p_gameplay_entities)
   {
-    for(int request_entity_id=0; request_entity_id < max_entity_count; ++request_entity_id)
+    submit_counters = gameplay_move_submit_counters();
+
+    for(int live_index=0; live_index < p_gameplay_entities.live_count; ++live_index)
     {
-      // cancel move if request id has garbage entity or has no velocity or is already moving
-      if ( is_garbage_flags[request_entity_id] ||
-         ( !(all_move_requests[request_entity_id].velocity.x + all_move_requests[request_entity_id].velocity.y) ) ||
-         ( velocities[request_entity_id].x || velocities[request_entity_id].y ))
-         { continue; }
+      int request_entity_id = p_gameplay_entities.live_ids[live_index];
+
+      // cancel move if request has no velocity or entity is already moving (garbage entities aren't in live_ids)
+      if ( !(all_move_requests[request_entity_id].velocity.x + all_move_requests[request_entity_id].velocity.y) ) continue;
+      ++submit_counters.requested;
+      if ( is_moving(request_entity_id) )
+      {
+        ++submit_counters.ignored_while_moving;
+        continue;
+      }
 
       sf::Vector2f request_velocity = all_move_requests[request_entity_id].velocity;
       int chain_destination_tile_index = p_tile_map.calculate_tile_map_index(all_move_requests[request_entity_id].destination_origin_position);
       int chain_index = 0;
-      int chain_entity_ids[tile_map_width];
-      memset(chain_entity_ids, -1, sizeof(chain_entity_ids));
 
 
       // start chain with request entity
       chain_entity_ids[chain_index] = request_entity_id;
       ++chain_index;
 
-      for(int chain_loop_index=0; chain_loop_index < sizeof(chain_entity_ids); ++chain_loop_index)
+      for(int chain_loop_index=0; chain_loop_index < chain_entity_ids.count; ++chain_loop_index)
       {
         // cancel move if entity is moving into a wall
         if ( p_tile_map.bitmap[chain_destination_tile_index] == static_cast<int>(tile_map_bitmap_type::WALL) )
         {
-          memset(chain_entity_ids, -1, sizeof(chain_entity_ids));
+          ++submit_counters.cancelled_by_wall;
           chain_index = 0;
           break;
         }
@@ -532,9 +767,15 @@ struct gameplay_entity_moves
         // cancel move if tile has moving entity or add stationary entity to chain
         if (current_other_entity_id != -1)
         {
-          if (velocities[current_other_entity_id].x || velocities[current_other_entity_id].y) // cancel move if chain leads to tile with moving entities
+          if (is_moving(current_other_entity_id)) // cancel move if chain leads to tile with moving entities
+          {
+            ++submit_counters.cancelled_by_moving;
+            chain_index = 0;
+            break;
+          }
+          else if (chain_index == chain_entity_ids.count) // cancel move if chain is longer than a row or column (can only happen without border walls)
           {
-            memset(chain_entity_ids, -1, sizeof(chain_entity_ids));
+            ++submit_counters.cancelled_by_length;
             chain_index = 0;
             break;
           }
@@ -548,61 +789,385 @@ struct gameplay_entity_moves
         // if tile is has destination entity the destination entity must be moving so cancel move
         if (destination_other_entity_id != -1)
         {
-          memset(chain_entity_ids, -1, sizeof(chain_entity_ids));
+          ++submit_counters.cancelled_by_destination;
           chain_index = 0;
           break;
         }
 
         chain_destination_tile_index = ( (chain_destination_tile_index + static_cast<int>(all_move_requests[request_entity_id].direction().x)) * static_cast<int>(request_velocity.x != 0) ) +
-                                       ( (chain_destination_tile_index + (tile_map_width * static_cast<int>(all_move_requests[request_entity_id].direction().y))) * static_cast<int>(request_velocity.y != 0) );
+                                       ( (chain_destination_tile_index + (p_tile_map.width * static_cast<int>(all_move_requests[request_entity_id].direction().y))) * static_cast<int>(request_velocity.y != 0) );
       }
 
 
+      if (chain_index > 0)
+      {
+        ++submit_counters.submitted;
+        submit_counters.chained += chain_index - 1;
+        ++submit_counters.chain_length_counts[ (chain_index < GAMEPLAY_CHAIN_LENGTH_BUCKETS) ? (chain_index - 1) : (GAMEPLAY_CHAIN_LENGTH_BUCKETS - 1) ];
+      }
+
       // register moves for each chained entity
       for(int chain_entity_ids_index=0; chain_entity_ids_index < chain_index; ++chain_entity_ids_index)
       {
         int id = chain_entity_ids[chain_entity_ids_index];
         sf::Vector2f offset = sf::Vector2f( (p_tile_map.tile_size_x * all_move_requests[request_entity_id].direction().x * static_cast<float>(chain_entity_ids_index)), (p_tile_map.tile_size_y * all_move_requests[request_entity_id].direction().y * static_cast<float>(chain_entity_ids_index)) );
 
-        current_origin_positions[id]     = all_move_requests[request_entity_id].current_origin_position     + offset;
-        destination_origin_positions[id] = all_move_requests[request_entity_id].destination_origin_position + offset;
-        velocities[id]                   = request_velocity / static_cast<float>(chain_index);
+        sf::Vector2f current_origin_position     = all_move_requests[request_entity_id].current_origin_position     + offset;
+        sf::Vector2f destination_origin_position = all_move_requests[request_entity_id].destination_origin_position + offset;
+        sf::Vector2f chain_velocity              = request_velocity / static_cast<float>(chain_index);
+
+        current_origin_x[id]     = current_origin_position.x;
+        current_origin_y[id]     = current_origin_position.y;
+        destination_origin_x[id] = destination_origin_position.x;
+        destination_origin_y[id] = destination_origin_position.y;
+        velocity_x[id]           = chain_velocity.x;
+        velocity_y[id]           = chain_velocity.y;
 
-        tile_index_to_current_entity_id[ p_tile_map.calculate_tile_map_index(current_origin_positions[id]) ]         = id;
-        tile_index_to_destination_entity_id[ p_tile_map.calculate_tile_map_index(destination_origin_positions[id]) ] = id;
+        tile_index_to_current_entity_id[ p_tile_map.calculate_tile_map_index(current_origin_position) ]         = id;
+        tile_index_to_destination_entity_id[ p_tile_map.calculate_tile_map_index(destination_origin_position) ] = id;
       }
     }
   }
 
-  void update_by_velocities(const float timestep, const tile_map<tile_map_width,tile_map_height>& p_tile_map)
+  template<int p_simd_width = GAMEPLAY_SIMD_WIDTH>
+  void update_by_velocities(const float timestep, const tile_map<tile_map_width,tile_map_height>& p_tile_map, const gameplay_entities<max_entity_count>& p_gameplay_entities)
   {
-    for(int id=0; id < max_entity_count; ++id)
+    /*
+       @remember: 1st pass steps positions and collects the ids that reached their destination, 2nd pass snaps those ids and updates tile occupancy
+       @remember: the vector kernels step every slot below id_bound instead of following live_ids so they can load whole blocks (non-moving slots have 0 velocity so stepping them changes nothing)
+       @remember: client and server should use the same GAMEPLAY_SIMD_WIDTH and fp flags (e.g. no fma contraction on one side only) so positions stay bit identical
+       @remember: p_simd_width picks a narrower kernel than the build's, only "benchmark check" does that to compare the kernels on the same ticks
+    */
+
+    static_assert( (p_simd_width == 1) || (p_simd_width == 4) || (p_simd_width == 8), "the movement kernels are 1, 4 or 8 wide" );
+    static_assert( p_simd_width <= GAMEPLAY_SIMD_WIDTH, "this build doesn't have that movement kernel" );
+
+    arrived_count    = 0;
+    moved_count      = 0;
+    tile_event_count = 0;
+
+    step_by_velocities(timestep, p_gameplay_entities, std::integral_constant<int, p_simd_width>());
+
+    // snap arrivals to their destination and update tile occupancy (order doesn't matter because a tile is only cleared by the entity that owns it)
+    for(int arrived_index=0; arrived_index < arrived_count; ++arrived_index)
+    {
+      int id = arrived_ids[arrived_index];
+
+      current_origin_x[id] = destination_origin_x[id];
+      current_origin_y[id] = destination_origin_y[id];
+
+      int tile_index          = p_tile_map.calculate_tile_map_index(current_origin_position(id));
+      int previous_tile_index = calculate_previous_tile_index(id, tile_index, p_tile_map);
+
+      velocity_x[id] = 0.0f;
+      velocity_y[id] = 0.0f;
+      if (tile_index_to_current_entity_id[previous_tile_index] == id) tile_index_to_current_entity_id[previous_tile_index] = -1;
+      tile_index_to_current_entity_id[tile_index]     = id;
+      tile_index_to_destination_entity_id[tile_index] = -1;
+
+      tile_events[tile_event_count].gameplay_entity_id = id;
+      tile_events[tile_event_count].tile_index         = previous_tile_index;
+      tile_events[tile_event_count].type               = gameplay_tile_event_type::EXIT;
+      ++tile_event_count;
+
+      tile_events[tile_event_count].gameplay_entity_id = id;
+      tile_events[tile_event_count].tile_index         = tile_index;
+      tile_events[tile_event_count].type               = gameplay_tile_event_type::ENTER;
+      ++tile_event_count;
+    }
+  }
+
+  void add_entity(const int id, const sf::Vector2f& origin_position, const tile_map<tile_map_width,tile_map_height>& p_tile_map)  // call after gameplay_entities::spawn
+  {
+    current_origin_x[id]     = origin_position.x;
+    current_origin_y[id]     = origin_position.y;
+    destination_origin_x[id] = 0.0f;
+    destination_origin_y[id] = 0.0f;
+    velocity_x[id]           = 0.0f;
+    velocity_y[id]           = 0.0f;
+
+    tile_index_to_current_entity_id[p_tile_map.calculate_tile_map_index(origin_position)] = id;
+  }
+
+  void add_moving_entity(const int id, const sf::Vector2f& origin_position, const sf::Vector2f& p_destination_origin_position, const sf::Vector2f& p_velocity, const tile_map<tile_map_width,tile_map_height>& p_tile_map)  // like add_entity but already one tile into a move, used to restore replicated state
+  {
+    current_origin_x[id]     = origin_position.x;
+    current_origin_y[id]     = origin_position.y;
+    destination_origin_x[id] = p_destination_origin_position.x;
+    destination_origin_y[id] = p_destination_origin_position.y;
+    velocity_x[id]           = p_velocity.x;
+    velocity_y[id]           = p_velocity.y;
+
+    int destination_tile_index = p_tile_map.calculate_tile_map_index(p_destination_origin_position);
+    tile_index_to_current_entity_id[ calculate_previous_tile_index(id, destination_tile_index, p_tile_map) ] = id;
+    tile_index_to_destination_entity_id[destination_tile_index] = id;
+  }
+
+  void remove_entity(const int id, const tile_map<tile_map_width,tile_map_height>& p_tile_map)  // call with gameplay_entities::despawn so the entity stops occupying its tiles
+  {
+    if (is_moving(id))
+    {
+      int destination_tile_index = p_tile_map.calculate_tile_map_index(destination_origin_position(id));
+      int start_tile_index       = calculate_previous_tile_index(id, destination_tile_index, p_tile_map);
+
+      if (tile_index_to_destination_entity_id[destination_tile_index] == id) tile_index_to_destination_entity_id[destination_tile_index] = -1;
+      if (tile_index_to_current_entity_id[start_tile_index] == id)           tile_index_to_current_entity_id[start_tile_index]           = -1;
+    }
+    else
+    {
+      int tile_index = p_tile_map.calculate_tile_map_index(current_origin_position(id));
+      if (tile_index_to_current_entity_id[tile_index] == id) tile_index_to_current_entity_id[tile_index] = -1;
+    }
+
+    // garbage slots must keep 0 velocity because the vector kernels step them too
+    destination_origin_x[id] = 0.0f;
+    destination_origin_y[id] = 0.0f;
+    velocity_x[id]           = 0.0f;
+    velocity_y[id]           = 0.0f;
+  }
+
+  private:
+    int calculate_previous_tile_index(const int id, const int tile_index, const tile_map<tile_map_width,tile_map_height>& p_tile_map) const  // the tile a moving entity came from
+    {
+      return ( (tile_index - 1)                * static_cast<int>(velocity_x[id] > 0.0f) ) +
+             ( (tile_index + 1)                * static_cast<int>(velocity_x[id] < 0.0f) ) +
+             ( (tile_index - p_tile_map.width) * static_cast<int>(velocity_y[id] > 0.0f) ) +
+             ( (tile_index + p_tile_map.width) * static_cast<int>(velocity_y[id] < 0.0f) );
+    }
+
+    void collect_ids(const int first_id, int lane_mask, int* const ids, int& id_count) const  // appends the id of each set lane without branching on the lane
     {
-      if ( !(velocities[id].x || velocities[id].y) ) continue;  // nothing to update if not moving
+      for(int lane=0; lane_mask; ++lane, lane_mask >>= 1)
+      {
+        ids[id_count] = first_id + lane;
+        id_count += lane_mask & 1;
+      }
+    }
+
+    #if GAMEPLAY_SIMD_WIDTH >= 8
+    void step_by_velocities(const float timestep, const gameplay_entities<max_entity_count>& p_gameplay_entities, std::integral_constant<int, 8>)  // 1st pass of update_by_velocities, 8 slots per __m256
+    {
+      const int block_end   = ((p_gameplay_entities.id_bound + 7) / 8) * 8;
+      const __m256 timesteps = _mm256_set1_ps(timestep);
+      const __m256 zeros     = _mm256_setzero_ps();
+
+      for(int id=0; id < block_end; id += 8)
+      {
+        __m256 current_x     = _mm256_loadu_ps(current_origin_x + id);
+        __m256 current_y     = _mm256_loadu_ps(current_origin_y + id);
+        __m256 destination_x = _mm256_loadu_ps(destination_origin_x + id);
+        __m256 destination_y = _mm256_loadu_ps(destination_origin_y + id);
+        __m256 velocities_x  = _mm256_loadu_ps(velocity_x + id);
+        __m256 velocities_y  = _mm256_loadu_ps(velocity_y + id);
+
+        collect_ids(id, _mm256_movemask_ps(_mm256_or_ps(_mm256_cmp_ps(velocities_x, zeros, _CMP_NEQ_OQ), _mm256_cmp_ps(velocities_y, zeros, _CMP_NEQ_OQ))), moved_ids, moved_count);
+
+        current_x = _mm256_add_ps(current_x, _mm256_mul_ps(velocities_x, timesteps));
+        current_y = _mm256_add_ps(current_y, _mm256_mul_ps(velocities_y, timesteps));
+        _mm256_storeu_ps(current_origin_x + id, current_x);
+        _mm256_storeu_ps(current_origin_y + id, current_y);
+
+        __m256 reached_destination = _mm256_or_ps( _mm256_or_ps( _mm256_and_ps(_mm256_cmp_ps(velocities_x, zeros, _CMP_GT_OQ), _mm256_cmp_ps(current_x, destination_x, _CMP_GE_OQ)),
+                                                                 _mm256_and_ps(_mm256_cmp_ps(velocities_x, zeros, _CMP_LT_OQ), _mm256_cmp_ps(current_x, destination_x, _CMP_LE_OQ)) ),
+                                                   _mm256_or_ps( _mm256_and_ps(_mm256_cmp_ps(velocities_y, zeros, _CMP_GT_OQ), _mm256_cmp_ps(current_y, destination_y, _CMP_GE_OQ)),
+                                                                 _mm256_and_ps(_mm256_cmp_ps(velocities_y, zeros, _CMP_LT_OQ), _mm256_cmp_ps(current_y, destination_y, _CMP_LE_OQ)) ) );
+
+        collect_ids(id, _mm256_movemask_ps(reached_destination), arrived_ids, arrived_count);
+      }
+    }
+    #endif
+
+    #if GAMEPLAY_SIMD_WIDTH >= 4
+    void step_by_velocities(const float timestep, const gameplay_entities<max_entity_count>& p_gameplay_entities, std::integral_constant<int, 4>)  // 4 slots per __m128
+    {
+      const int block_end   = ((p_gameplay_entities.id_bound + 3) / 4) * 4;
+      const __m128 timesteps = _mm_set1_ps(timestep);
+      const __m128 zeros     = _mm_setzero_ps();
 
-      current_origin_positions[id] += (velocities[id] * timestep);
+      for(int id=0; id < block_end; id += 4)
+      {
+        __m128 current_x     = _mm_loadu_ps(current_origin_x + id);
+        __m128 current_y     = _mm_loadu_ps(current_origin_y + id);
+        __m128 destination_x = _mm_loadu_ps(destination_origin_x + id);
+        __m128 destination_y = _mm_loadu_ps(destination_origin_y + id);
+        __m128 velocities_x  = _mm_loadu_ps(velocity_x + id);
+        __m128 velocities_y  = _mm_loadu_ps(velocity_y + id);
+
+        collect_ids(id, _mm_movemask_ps(_mm_or_ps(_mm_cmpneq_ps(velocities_x, zeros), _mm_cmpneq_ps(velocities_y, zeros))), moved_ids, moved_count);
+
+        current_x = _mm_add_ps(current_x, _mm_mul_ps(velocities_x, timesteps));
+        current_y = _mm_add_ps(current_y, _mm_mul_ps(velocities_y, timesteps));
+        _mm_storeu_ps(current_origin_x + id, current_x);
+        _mm_storeu_ps(current_origin_y + id, current_y);
+
+        __m128 reached_destination = _mm_or_ps( _mm_or_ps( _mm_and_ps(_mm_cmpgt_ps(velocities_x, zeros), _mm_cmpge_ps(current_x, destination_x)),
+                                                           _mm_and_ps(_mm_cmplt_ps(velocities_x, zeros), _mm_cmple_ps(current_x, destination_x)) ),
+                                                _mm_or_ps( _mm_and_ps(_mm_cmpgt_ps(velocities_y, zeros), _mm_cmpge_ps(current_y, destination_y)),
+                                                           _mm_and_ps(_mm_cmplt_ps(velocities_y, zeros), _mm_cmple_ps(current_y, destination_y)) ) );
+
+        collect_ids(id, _mm_movemask_ps(reached_destination), arrived_ids, arrived_count);
+      }
+    }
+    #endif
 
-      bool reached_destination = ( (velocities[id].x > 0.0f) && (current_origin_positions[id].x >= destination_origin_positions[id].x) ) ||
-                                 ( (velocities[id].x < 0.0f) && (current_origin_positions[id].x <= destination_origin_positions[id].x) ) ||
-                                 ( (velocities[id].y > 0.0f) && (current_origin_positions[id].y >= destination_origin_positions[id].y) ) ||
-                                 ( (velocities[id].y < 0.0f) && (current_origin_positions[id].y <= destination_origin_positions[id].y) );
-                                
-      if (reached_destination)
+    void step_by_velocities(const float timestep, const gameplay_entities<max_entity_count>& p_gameplay_entities, std::integral_constant<int, 1>)  // live entities one at a time
+    {
+      for(int live_index=0; live_index < p_gameplay_entities.live_count; ++live_index)
       {
-        current_origin_positions[id] = destination_origin_positions[id];
-
-        int tile_index          = p_tile_map.calculate_tile_map_index(current_origin_positions[id]);
-        int previous_tile_index = ( (tile_index - 1)              * static_cast<int>(velocities[id].x > 0.0f) ) +
-                                  ( (tile_index + 1)              * static_cast<int>(velocities[id].x < 0.0f) ) +
-                                  ( (tile_index - tile_map_width) * static_cast<int>(velocities[id].y > 0.0f) ) +
-                                  ( (tile_index + tile_map_width) * static_cast<int>(velocities[id].y < 0.0f) );
-   
-        velocities[id] = sf::Vector2f(0.0f,0.0f);
-        if (tile_index_to_current_entity_id[previous_tile_index] == id) tile_index_to_current_entity_id[previous_tile_index] = -1;
-        tile_index_to_current_entity_id[tile_index]     = id;
-        tile_index_to_destination_entity_id[tile_index] = -1;
+        int id = p_gameplay_entities.live_ids[live_index];
+        if ( !is_moving(id) ) continue;  // nothing to update if not moving
+
+        moved_ids[moved_count] = id;
+        ++moved_count;
+
+        current_origin_x[id] += velocity_x[id] * timestep;
+        current_origin_y[id] += velocity_y[id] * timestep;
+
+        bool reached_destination = ( (velocity_x[id] > 0.0f) && (current_origin_x[id] >= destination_origin_x[id]) ) ||
+                                   ( (velocity_x[id] < 0.0f) && (current_origin_x[id] <= destination_origin_x[id]) ) ||
+                                   ( (velocity_y[id] > 0.0f) && (current_origin_y[id] >= destination_origin_y[id]) ) ||
+                                   ( (velocity_y[id] < 0.0f) && (current_origin_y[id] <= destination_origin_y[id]) );
+
+        arrived_ids[arrived_count] = id;
+        arrived_count += reached_destination;
       }
     }
+
+};
+
+
+/* trigger stuff */
+enum class tile_trigger_type : int
+{
+  NONE = 0,
+  TEST = 1
+};
+
+
+/* player stuff */
+#define PLAYER_TILES_PER_SECOND 3.0f
+
+enum class player_input_direction : std::uint8_t  // also the wire format of player input (see protocol.h)
+{
+  NONE  = 0,
+  LEFT  = 1,
+  RIGHT = 2,
+  UP    = 3,
+  DOWN  = 4
+};
+
+template<int p_width, int p_height>
+inline sf::Vector2f player_velocity_from_input(const player_input_direction direction, const tile_map<p_width,p_height>& p_tile_map)
+{
+  switch (direction)
+  {
+    case player_input_direction::LEFT:  return sf::Vector2f( -PLAYER_TILES_PER_SECOND * p_tile_map.tile_size_x, 0.0f );
+    case player_input_direction::RIGHT: return sf::Vector2f(  PLAYER_TILES_PER_SECOND * p_tile_map.tile_size_x, 0.0f );
+    case player_input_direction::UP:    return sf::Vector2f( 0.0f, -PLAYER_TILES_PER_SECOND * p_tile_map.tile_size_y );
+    case player_input_direction::DOWN:  return sf::Vector2f( 0.0f,  PLAYER_TILES_PER_SECOND * p_tile_map.tile_size_y );
+    default:                            return sf::Vector2f( 0.0f, 0.0f );
+  }
+}
+
+struct player_move_chamber
+{
+  /*
+     @remember: the last held direction is kept (chambered) while at least a third of a tile of the current move remains and is submitted as soon as the player stops
+     @remember: the local client, the server (one per remote player) and client prediction all use this so they produce the same moves from the same input
+  */
+
+  player_input_direction direction = player_input_direction::NONE;  // NONE when nothing is chambered, a direction rather than a velocity so it means the same on every tile size
+
+  void hold(const player_input_direction held_direction)  // call every tick with the held direction (NONE keeps the chamber)
+  {
+    if (held_direction != player_input_direction::NONE) direction = held_direction;
+  }
+
+  template<int max_entity_count, int tile_map_width, int tile_map_height>
+  void generate_move_request(const int id, const gameplay_entities<max_entity_count>& p_gameplay_entities, const gameplay_entity_moves<max_entity_count,tile_map_width,tile_map_height>& p_entity_moves, const tile_map<tile_map_width,tile_map_height>& p_tile_map, gameplay_entity_move_request* const all_move_requests)
+  {
+    // if already moving and at least a third of a tile remains then keep the chamber else if already moving reset the chamber else if stationary then move player
+    if ( (p_entity_moves.velocity_x[id] && (std::abs(p_entity_moves.destination_origin_x[id] - p_entity_moves.current_origin_x[id]) >= (p_tile_map.tile_size_x / 3.0f)) ) ||
+         (p_entity_moves.velocity_y[id] && (std::abs(p_entity_moves.destination_origin_y[id] - p_entity_moves.current_origin_y[id]) >= (p_tile_map.tile_size_y / 3.0f)) ) )
+    {
+      return;
+    }
+    else if ( !p_entity_moves.is_moving(id) )
+    {
+      if (direction == player_input_direction::NONE) return;
+
+      const sf::Vector2f velocity = player_velocity_from_input(direction, p_tile_map);
+
+      gameplay_entity_move_request& move_request = all_move_requests[id];
+      move_request.velocity                = velocity;
+      move_request.current_origin_position = p_gameplay_entities.collision_vertices[id * 4];
+
+      if (velocity.x > 0) move_request.destination_origin_position = move_request.current_origin_position + sf::Vector2f(p_tile_map.tile_size_x, 0.0f);
+      if (velocity.x < 0) move_request.destination_origin_position = move_request.current_origin_position + sf::Vector2f(-1.0f * p_tile_map.tile_size_x, 0.0f);
+      if (velocity.y > 0) move_request.destination_origin_position = move_request.current_origin_position + sf::Vector2f(0.0f, p_tile_map.tile_size_y);
+      if (velocity.y < 0) move_request.destination_origin_position = move_request.current_origin_position + sf::Vector2f(0.0f, -1.0f * p_tile_map.tile_size_y);
+    }
+    else direction = player_input_direction::NONE; // reset chamber
+  }
+};
+
+template<int p_width, int p_height>
+struct tile_triggers
+{
+  /*
+     @remember: triggers are only looked at when gameplay_entity_moves emits a tile event for their tile so the cost is proportional to arrivals, not tile_count
+     @remember: one trigger per tile, a handler can remove triggers (including the one being handled) while events are dispatched
+  */
+
+  tile_array<tile_trigger_type, p_width * p_height> trigger_types;   // NONE when the tile has no trigger
+  tile_array<int, p_width * p_height> trigger_tile_indexes;          // packed list of tiles that have a trigger
+  int trigger_count = 0;
+
+  private:
+    tile_array<int, p_width * p_height> trigger_tile_list_indexes;   // where each tile is in trigger_tile_indexes so remove_trigger is O(1)
+  public:
+
+  tile_triggers(const tile_map<p_width,p_height>& p_tile_map) : trigger_types(p_tile_map.tile_count), trigger_tile_indexes(p_tile_map.tile_count), trigger_tile_list_indexes(p_tile_map.tile_count)
+  {
+    for(int tile_index=0; tile_index < trigger_types.count; ++tile_index) trigger_types[tile_index] = tile_trigger_type::NONE;
+  }
+
+  void add_trigger(const int tile_index, const tile_trigger_type type)  // replaces the tile's trigger if it already has one
+  {
+    assert(type != tile_trigger_type::NONE);
+
+    if (trigger_types[tile_index] == tile_trigger_type::NONE)
+    {
+      trigger_tile_indexes[trigger_count]   = tile_index;
+      trigger_tile_list_indexes[tile_index] = trigger_count;
+      ++trigger_count;
+    }
+
+    trigger_types[tile_index] = type;
+  }
+
+  void remove_trigger(const int tile_index)
+  {
+    if (trigger_types[tile_index] == tile_trigger_type::NONE) return;
+
+    int last_tile_index = trigger_tile_indexes[trigger_count - 1];
+    trigger_tile_indexes[trigger_tile_list_indexes[tile_index]] = last_tile_index;
+    trigger_tile_list_indexes[last_tile_index]                  = trigger_tile_list_indexes[tile_index];
+    --trigger_count;
+
+    trigger_types[tile_index] = tile_trigger_type::NONE;
+  }
+
+  template<typename t_handler>
+  void dispatch_events(const gameplay_tile_event* const tile_events, const int tile_event_count, t_handler&& handler)  // handler(tile_trigger_type, const gameplay_tile_event&) is called for each event on a trigger tile
+  {
+    for(int event_index=0; event_index < tile_event_count; ++event_index)
+    {
+      const gameplay_tile_event& tile_event = tile_events[event_index];
+      tile_trigger_type type = trigger_types[tile_event.tile_index];
+
+      if (type != tile_trigger_type::NONE) handler(type, tile_event);
+    }
   }
 
 };
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include "gameplay.h"
+
+
+
+/* gameplay_entity rendering stuff */
+template<int p_max_size>
+struct gameplay_entity_sprites
+{
+  /*
+     @remember: only the client needs this, the simulation state lives in gameplay_entities
+     @remember: vertex_buffer is packed in live_ids order (slot i is live_ids[i]) so only drawn_vertex_count vertices need to be drawn
+  */
+
+  sf::Vertex vertex_buffer[p_max_size * 4];           // 4 vertices per entity
+  sf::Texture sprite_sheet_texture;                   // a sprite sheet where each row is a separate entity and each column is a different frame for an animation (the first row is transparent)
+  sf::Vector2f sprite_vertex_offsets[p_max_size * 4]; // offset of each sprite vertex from the entity origin (top-left collision vertex)
+  const int sprite_sheet_side_length;                 // the pixel length and width of each entity animation frame
+  const int max_size = p_max_size;
+  const int vertex_count = p_max_size * 4;            // 4 vertices per entity
+  int drawn_vertex_count = 0;                         // 4 vertices per live entity, set by update_positions()
+
+
+  gameplay_entity_sprites(const char* sprite_sheet_texture_file_path, const int p_sprite_sheet_side_length) : sprite_sheet_side_length(p_sprite_sheet_side_length)
+  {
+    sprite_sheet_texture.loadFromFile(sprite_sheet_texture_file_path);
+
+    // need guarantee default values in case some memory never filled
+    for(auto& vertex : vertex_buffer)
+    {
+      vertex.position  = sf::Vector2f(0.0f, 0.0f);
+      vertex.texCoords = sf::Vector2f(0.0f, 0.0f);
+    }
+
+    for(auto& offset : sprite_vertex_offsets)
+    {
+      offset = sf::Vector2f(0.0f, 0.0f);
+    }
+  }
+
+  void update_positions(const gameplay_entities<p_max_size>& p_gameplay_entities, const sf::Vector2f* const all_origin_positions)  // origins can be interpolated between simulation ticks
+  {
+    for(int live_index=0,vertex=0; live_index < p_gameplay_entities.live_count; ++live_index,vertex += 4)
+    {
+      int entity_index = p_gameplay_entities.live_ids[live_index];
+      int offset       = entity_index * 4;
+      const sf::Vector2f& origin = all_origin_positions[entity_index];
+
+      vertex_buffer[vertex].position   = origin + sprite_vertex_offsets[offset];
+      vertex_buffer[vertex+1].position = origin + sprite_vertex_offsets[offset+1];
+      vertex_buffer[vertex+2].position = origin + sprite_vertex_offsets[offset+2];
+      vertex_buffer[vertex+3].position = origin + sprite_vertex_offsets[offset+3];
+    }
+
+    drawn_vertex_count = p_gameplay_entities.live_count * 4;
+  }
+
+  void update_tex_coords(const gameplay_entities<p_max_size>& p_gameplay_entities, const float elapsed_frame_time_seconds)  // update tex coords based on type and animation index
+  {
+    for(int live_index=0,vertex=0; live_index < p_gameplay_entities.live_count; ++live_index,vertex += 4)
+    {
+      int entity_index = p_gameplay_entities.live_ids[live_index];
+      float current_sprite_sheet_y_position = (float) (sprite_sheet_texture.getSize().y - sprite_sheet_side_length) - static_cast<int>(p_gameplay_entities.types[entity_index]) * sprite_sheet_side_length;
+      float current_sprite_sheet_x_position = (float) p_gameplay_entities.animation_indexes[entity_index] * sprite_sheet_side_length;
+
+      vertex_buffer[vertex].texCoords   = sf::Vector2f(current_sprite_sheet_x_position, current_sprite_sheet_y_position);
+      vertex_buffer[vertex+1].texCoords = sf::Vector2f(current_sprite_sheet_x_position + sprite_sheet_side_length, current_sprite_sheet_y_position);
+      vertex_buffer[vertex+2].texCoords = sf::Vector2f(current_sprite_sheet_x_position + sprite_sheet_side_length, current_sprite_sheet_y_position + sprite_sheet_side_length);
+      vertex_buffer[vertex+3].texCoords = sf::Vector2f(current_sprite_sheet_x_position, current_sprite_sheet_y_position + sprite_sheet_side_length);
+    }
+  }
+
+  #ifdef _DEBUG
+    sf::VertexArray* generate_debug_collision_line_vertices(const gameplay_entities<p_max_size>& p_gameplay_entities, const sf::Color color) const
+    {
+      static int debug_collision_line_vertex_count = p_max_size * 8; // 4 lines per entity and 2 vertices per line so 8 vertices per entity
+      static sf::VertexArray debug_collision_line_vertices(sf::Lines, debug_collision_line_vertex_count);
+
+      debug_collision_line_vertices.clear();
+      debug_collision_line_vertices.resize(debug_collision_line_vertex_count);
+
+      for(int live_index=0,i=0; live_index < p_gameplay_entities.live_count; ++live_index,i+=8)
+      {
+        int entity_vertex = p_gameplay_entities.live_ids[live_index] * 4;
+
+        debug_collision_line_vertices[i].position   = p_gameplay_entities.collision_vertices[entity_vertex];
+        debug_collision_line_vertices[i+1].position = p_gameplay_entities.collision_vertices[entity_vertex+1];
+        debug_collision_line_vertices[i].color      = color;
+        debug_collision_line_vertices[i+1].color    = color;
+
+        debug_collision_line_vertices[i+2].position = p_gameplay_entities.collision_vertices[entity_vertex+1];
+        debug_collision_line_vertices[i+3].position = p_gameplay_entities.collision_vertices[entity_vertex+2];
+        debug_collision_line_vertices[i+2].color    = color;
+        debug_collision_line_vertices[i+3].color    = color;
+
+        debug_collision_line_vertices[i+4].position = p_gameplay_entities.collision_vertices[entity_vertex+2];
+        debug_collision_line_vertices[i+5].position = p_gameplay_entities.collision_vertices[entity_vertex+3];
+        debug_collision_line_vertices[i+4].color    = color;
+        debug_collision_line_vertices[i+5].color    = color;
+
+        debug_collision_line_vertices[i+6].position = p_gameplay_entities.collision_vertices[entity_vertex+3];
+        debug_collision_line_vertices[i+7].position = p_gameplay_entities.collision_vertices[entity_vertex];
+        debug_collision_line_vertices[i+6].color    = color;
+        debug_collision_line_vertices[i+7].color    = color;
+      }
+
+      return &debug_collision_line_vertices;
+    }
+
+    sf::VertexArray* generate_debug_line_vertices(const gameplay_entities<p_max_size>& p_gameplay_entities, const sf::Color color) const
+    {
+      static int debug_line_vertex_count = max_size * 8; // 4 lines per entity and 2 vertices per line so 8 vertices per entity
+      static sf::VertexArray debug_line_vertices(sf::Lines, debug_line_vertex_count);
+
+      debug_line_vertices.clear();
+      debug_line_vertices.resize(debug_line_vertex_count);
+
+      for(int i=0,entity_vertex=0; entity_vertex < drawn_vertex_count; i+=8,entity_vertex+=4)  // vertex_buffer is packed so no garbage slots to skip
+      {
+
+        debug_line_vertices[i].position   = this->vertex_buffer[entity_vertex].position;
+        debug_line_vertices[i+1].position = this->vertex_buffer[entity_vertex+1].position;
+        debug_line_vertices[i].color      = color;
+        debug_line_vertices[i+1].color    = color;
+
+        debug_line_vertices[i+2].position = this->vertex_buffer[entity_vertex+1].position;
+        debug_line_vertices[i+3].position = this->vertex_buffer[entity_vertex+2].position;
+        debug_line_vertices[i+2].color    = color;
+        debug_line_vertices[i+3].color    = color;
+
+        debug_line_vertices[i+4].position = this->vertex_buffer[entity_vertex+2].position;
+        debug_line_vertices[i+5].position = this->vertex_buffer[entity_vertex+3].position;
+        debug_line_vertices[i+4].color    = color;
+        debug_line_vertices[i+5].color    = color;
+
+        debug_line_vertices[i+6].position = this->vertex_buffer[entity_vertex+3].position;
+        debug_line_vertices[i+7].position = this->vertex_buffer[entity_vertex].position;
+        debug_line_vertices[i+6].color    = color;
+        debug_line_vertices[i+7].color    = color;
+      }
+
+      return &debug_line_vertices;
+    }
+
+    void generate_debug_index_text(const gameplay_entities<p_max_size>& p_gameplay_entities, sf::Text (&debug_entity_index_text)[p_max_size], const sf::Font& font, const sf::Color color) const
+    {
+      for(auto& text : debug_entity_index_text) text.setString("");
+
+      for(int live_index=0; live_index < p_gameplay_entities.live_count; ++live_index)
+      {
+        int entity_index = p_gameplay_entities.live_ids[live_index];
+
+        int character_size = static_cast<int>( p_gameplay_entities.collision_vertices[(entity_index * 4) + 1].x - p_gameplay_entities.collision_vertices[entity_index * 4].x ) / 4;
+
+        debug_entity_index_text[entity_index].setFont(font);
+        debug_entity_index_text[entity_index].setString(std::to_string(entity_index));
+        debug_entity_index_text[entity_index].setFillColor(color);
+        debug_entity_index_text[entity_index].setStyle(sf::Text::Bold);
+        debug_entity_index_text[entity_index].setCharacterSize(character_size);
+        debug_entity_index_text[entity_index].setPosition( p_gameplay_entities.collision_vertices[entity_index * 4] );
+      }
+    }
+  #endif
+
+};
+
+
+
+/* tile_map rendering stuff */
+template<int p_width, int p_height>
+struct tile_map_sprites
+{
+  // @remember: first 4 vertices in tile_map vertex buffer are for background tile
+
+  const int vertex_count;                                                                                  // (4 vertices per tile) + 4 vertices for background
+  sf::Texture tiles_texture;                                                                               // a tile sheet of tile_sheet_side_length x tile_sheet_side_length sized tiles where the first tile is the default background
+  tile_array<sf::Vertex, (p_width * p_height) ? ((p_width * p_height * 4) + 4) : RUNTIME_TILE_MAP_SIZE> vertex_buffer;  // (4 vertices per tile) + 4 vertices for background
+  const int tile_sheet_side_length;                                                                        // pixel width and height for a tile in tile sheet
+
+  tile_map_sprites(const char* tiles_texture_file_path, const tile_map<p_width,p_height>& p_tile_map, const int p_tile_side_length) : vertex_count((p_tile_map.tile_count * 4) + 4), vertex_buffer((p_tile_map.tile_count * 4) + 4), tile_sheet_side_length(p_tile_side_length)
+  {
+    const float tile_size_x = p_tile_map.tile_size_x;
+    const float tile_size_y = p_tile_map.tile_size_y;
+    const int   width       = p_tile_map.width;
+    const int   height      = p_tile_map.height;
+
+    tiles_texture.loadFromFile(tiles_texture_file_path);
+
+    // assign screen coordinates and texture coordinates for background
+    this->vertex_buffer[0].position  = sf::Vector2f(0.0f, 0.0f);
+    this->vertex_buffer[0].texCoords = sf::Vector2f(0.0f , 0.0f);
+    this->vertex_buffer[1].position  = sf::Vector2f(tile_size_x * width, 0);
+    this->vertex_buffer[1].texCoords = sf::Vector2f((float) tile_sheet_side_length, 0.0f);
+    this->vertex_buffer[2].position  = sf::Vector2f(tile_size_x * width, tile_size_y * height);
+    this->vertex_buffer[2].texCoords = sf::Vector2f((float) tile_sheet_side_length, (float) tile_sheet_side_length);
+    this->vertex_buffer[3].position  = sf::Vector2f(0.0f, tile_size_y * height);
+    this->vertex_buffer[3].texCoords = sf::Vector2f(0.0f, (float) tile_sheet_side_length);
+
+    // assign screen coordinates for each vertex in tiles
+    for(int y=0,vertex=4; y < height; ++y)
+    for(int x=0         ; x < width ; ++x, vertex+=4)
+    {
+      this->vertex_buffer[vertex].position   = sf::Vector2f(x * tile_size_x    , y * tile_size_y);
+      this->vertex_buffer[vertex+1].position = sf::Vector2f((x+1) * tile_size_x, y * tile_size_y);
+      this->vertex_buffer[vertex+2].position = sf::Vector2f((x+1) * tile_size_x, (y+1) * tile_size_y);
+      this->vertex_buffer[vertex+3].position = sf::Vector2f(x * tile_size_x    , (y+1) * tile_size_y);
+    }
+  }
+
+  void update_tex_coords_from_bitmap(const tile_map<p_width,p_height>& p_tile_map)
+  {
+    for(int tile=0, vertex=4,texture_offset; tile < p_tile_map.tile_count; ++tile, vertex+=4)
+    {
+      texture_offset = p_tile_map.bitmap[tile] * tile_sheet_side_length;
+
+      this->vertex_buffer[vertex].texCoords   = sf::Vector2f((float) texture_offset                         , 0.0f);
+      this->vertex_buffer[vertex+1].texCoords = sf::Vector2f((float) texture_offset + tile_sheet_side_length, 0.0f);
+      this->vertex_buffer[vertex+2].texCoords = sf::Vector2f((float) texture_offset + tile_sheet_side_length, (float) tile_sheet_side_length);
+      this->vertex_buffer[vertex+3].texCoords = sf::Vector2f((float) texture_offset                         , (float) tile_sheet_side_length);
+    }
+  }
+
+  #ifdef _DEBUG
+    sf::VertexArray* generate_debug_line_vertices(const sf::Color color) const
+    {
+      static int debug_lines_vertex_count = vertex_count * 2; // 4 lines per tile and 2 vertices per line so 8 vertices per tile, the additional 1 is for background tile
+      static sf::VertexArray debug_line_vertices(sf::Lines, debug_lines_vertex_count);
+
+      for(size_t i=0,tile_map_vertex=0; i < debug_lines_vertex_count; i+=8,tile_map_vertex+=4)
+      {
+        debug_line_vertices[i].position   = this->vertex_buffer[tile_map_vertex].position;
+        debug_line_vertices[i+1].position = this->vertex_buffer[tile_map_vertex+1].position;
+        debug_line_vertices[i].color      = color;
+        debug_line_vertices[i+1].color    = color;
+
+        debug_line_vertices[i+2].position = this->vertex_buffer[tile_map_vertex+1].position;
+        debug_line_vertices[i+3].position = this->vertex_buffer[tile_map_vertex+2].position;
+        debug_line_vertices[i+2].color    = color;
+        debug_line_vertices[i+3].color    = color;
+
+        debug_line_vertices[i+4].position = this->vertex_buffer[tile_map_vertex+2].position;
+        debug_line_vertices[i+5].position = this->vertex_buffer[tile_map_vertex+3].position;
+        debug_line_vertices[i+4].color    = color;
+        debug_line_vertices[i+5].color    = color;
+
+        debug_line_vertices[i+6].position = this->vertex_buffer[tile_map_vertex+3].position;
+        debug_line_vertices[i+7].position = this->vertex_buffer[tile_map_vertex].position;
+        debug_line_vertices[i+6].color    = color;
+        debug_line_vertices[i+7].color    = color;
+      }
+
+      return &debug_line_vertices;
+    }
+
+    void generate_debug_tile_index_text(const tile_map<p_width,p_height>& p_tile_map, sf::Text* const debug_tile_index_text, const sf::Font& font, const sf::Color color) const  // debug_tile_index_text needs tile_count elements
+    {
+      static int character_size = static_cast<int>(p_tile_map.tile_size_x) / 4;
+
+      for(int i=0, tile_index=1; i < p_tile_map.tile_count; ++tile_index, ++i)
+      {
+        debug_tile_index_text[i].setFont(font);
+        debug_tile_index_text[i].setString(std::to_string(i));
+        debug_tile_index_text[i].setFillColor(color);
+        debug_tile_index_text[i].setStyle(sf::Text::Bold);
+        debug_tile_index_text[i].setCharacterSize(character_size);
+        debug_tile_index_text[i].setPosition( this->vertex_buffer[tile_index * 4].position );
+      }
+    }
+  #endif
+
+};
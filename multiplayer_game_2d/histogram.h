@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <stdio.h>
+#include <string.h>
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+
+
+/*
+   @remember: HDR-style log-linear histogram, every power of two is split into HISTOGRAM_SUB_BUCKET_COUNT buckets so any recorded value is off by at most 1/16 (6.25%) and recording is a bit scan and an increment
+   @remember: values are unitless (ns, us or profiler ticks for zones), reports take the microseconds per value so buckets never need rescaling
+   @remember: percentiles report the top of their bucket (capped at the exact max) so tails are never understated
+   @remember: reports are one JSON object per line on stdout, e.g. {"histogram":"frame","source":"game","count":600,"mean_us":16.6,"p50_us":16.5,"p99_us":17.2,"p999_us":33.1,"max_us":34.0}
+*/
+
+
+#define HISTOGRAM_SUB_BUCKET_BITS   4
+#define HISTOGRAM_SUB_BUCKET_COUNT  (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAX_EXPONENT      40                                                                                        // values at or above 2^40 (~18 minutes in ns) land in the last bucket
+#define HISTOGRAM_BUCKET_COUNT      (HISTOGRAM_SUB_BUCKET_COUNT + (HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_SUB_BUCKET_COUNT)
+#define HISTOGRAM_REPORT_SECONDS    10.0f                                                                                     // how often long runs print their histograms
+
+
+
+/* histogram stuff */
+inline int histogram_highest_bit(std::uint64_t value)  // value > 0
+{
+  #if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+  #elif defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+  #else
+    int index = 0;
+    while (value >>= 1) ++index;
+    return index;
+  #endif
+}
+
+struct latency_histogram
+{
+  std::uint64_t counts[HISTOGRAM_BUCKET_COUNT] = {};
+  std::uint64_t count = 0;
+  std::uint64_t sum   = 0;
+  std::uint64_t max   = 0;
+
+  static int bucket_index(const std::uint64_t value)
+  {
+    if (value < HISTOGRAM_SUB_BUCKET_COUNT) return static_cast<int>(value);  // exact below the first power of two that gets split
+
+    const int exponent = histogram_highest_bit(value);
+    if (exponent >= HISTOGRAM_MAX_EXPONENT) return HISTOGRAM_BUCKET_COUNT - 1;
+
+    const int sub_bucket = static_cast<int>( (value >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKET_COUNT - 1) );
+    return HISTOGRAM_SUB_BUCKET_COUNT + (exponent - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket;
+  }
+
+  static std::uint64_t bucket_highest_value(const int index)
+  {
+    if (index < HISTOGRAM_SUB_BUCKET_COUNT) return static_cast<std::uint64_t>(index);
+
+    const int exponent   = HISTOGRAM_SUB_BUCKET_BITS + (index - HISTOGRAM_SUB_BUCKET_COUNT) / HISTOGRAM_SUB_BUCKET_COUNT;
+    const int sub_bucket = (index - HISTOGRAM_SUB_BUCKET_COUNT) % HISTOGRAM_SUB_BUCKET_COUNT;
+    const int shift      = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+    return ( static_cast<std::uint64_t>(HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket + 1) << shift ) - 1;
+  }
+
+  void record(const std::uint64_t value)
+  {
+    ++counts[bucket_index(value)];
+    ++count;
+    sum += value;
+    if (value > max) max = value;
+  }
+
+  std::uint64_t percentile(const double percent) const  // 0 when empty
+  {
+    if (count == 0) return 0;
+
+    std::uint64_t rank = static_cast<std::uint64_t>( (percent / 100.0) * static_cast<double>(count) + 0.5 );
+    if (rank < 1)     rank = 1;
+    if (rank > count) rank = count;
+
+    std::uint64_t seen = 0;
+    for(int i=0; i < HISTOGRAM_BUCKET_COUNT; ++i)
+    {
+      seen += counts[i];
+      if (seen < rank) continue;
+      return ( (i < HISTOGRAM_BUCKET_COUNT - 1) && (bucket_highest_value(i) < max) ) ? bucket_highest_value(i) : max;  // the last bucket also holds every value past the range
+    }
+    return max;
+  }
+
+  void merge(const latency_histogram& other)
+  {
+    for(int i=0; i < HISTOGRAM_BUCKET_COUNT; ++i) counts[i] += other.counts[i];
+    count += other.count;
+    sum   += other.sum;
+    if (other.max > max) max = other.max;
+  }
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  void print(const char* const source, const char* const name, const double microseconds_per_value) const
+  {
+    printf("{\"histogram\":\"%s\",\"source\":\"%s\",\"count\":%llu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"p999_us\":%.3f,\"max_us\":%.3f}\n", name, source, static_cast<unsigned long long>(count),
+           count ? (static_cast<double>(sum) / static_cast<double>(count) * microseconds_per_value) : 0.0,
+           static_cast<double>(percentile(50.0)) * microseconds_per_value, static_cast<double>(percentile(99.0)) * microseconds_per_value,
+           static_cast<double>(percentile(99.9)) * microseconds_per_value, static_cast<double>(max) * microseconds_per_value);
+  }
+};
+
+
+
+/* tick stuff */
+enum class tick_phase : int  // the simulation systems timed every tick, names match their profiler zones
+{
+  TICK                 = 0,
+  MOVE_GENERATION      = 1,
+  SUBMIT_ALL_MOVES     = 2,
+  UPDATE_BY_VELOCITIES = 3,
+  SET_ALL_POSITIONS    = 4,
+  TILE_BUCKETS         = 5,
+  TRIGGERS             = 6,
+  COUNT                = 7
+};
+
+const char* const tick_phase_names[] = { "tick", "move generation", "submit_all_moves", "update_by_velocities", "set_all_positions", "tile buckets", "triggers" };
+
+struct tick_time_histograms  // one per simulation thread, filled by the PROFILE_TICK_PHASE zones in profiler ticks
+{
+  latency_histogram phases[static_cast<int>(tick_phase::COUNT)];
+
+  void merge(const tick_time_histograms& other)
+  {
+    for(int i=0; i < static_cast<int>(tick_phase::COUNT); ++i) phases[i].merge(other.phases[i]);
+  }
+
+  void print(const char* const source, const double microseconds_per_tick) const
+  {
+    for(int i=0; i < static_cast<int>(tick_phase::COUNT); ++i) phases[i].print(source, tick_phase_names[i], microseconds_per_tick);
+  }
+};
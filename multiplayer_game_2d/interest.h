@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include "gameplay.h"
+
+
+/*
+   @remember: the server only sends a client the entities around its own entity, found through the tile buckets of gameplay_entity_ids_per_tile so the cost is the view area and not the map
+   @remember: an entity enters when it is in the view and leaves only once it is INTEREST_HYSTERESIS_TILES past it, so entities moving along the edge don't flicker in and out
+   @remember: an entity that leaves is absent in the client's next STATE, the client despawns it like any other removed entity
+*/
+
+
+#define INTEREST_VIEW_HALF_WIDTH   17   // tiles either side of the client's entity, a 17x11 map is always fully in view
+#define INTEREST_VIEW_HALF_HEIGHT  11
+#define INTEREST_HYSTERESIS_TILES  2
+
+
+
+/* interest stuff */
+struct area_of_interest  // what one client can see
+{
+  int                    relevant_count = 0;
+  std::unique_ptr<int[]> relevant_ids;                        // the entities to send this tick
+
+  private:
+    std::unique_ptr<std::uint32_t[]> relevant_stamps;         // update_count of the last update the entity was relevant in
+    std::unique_ptr<std::uint32_t[]> visit_stamps;            // dedupes entities binned in several tiles
+    std::uint32_t                    update_count = 1;        // stamps start at 0 so nothing is relevant before the first update
+  public:
+
+  explicit area_of_interest(const int entity_capacity) : relevant_ids(new int[entity_capacity]), relevant_stamps(new std::uint32_t[entity_capacity]), visit_stamps(new std::uint32_t[entity_capacity])
+  {
+    for(int id=0; id < entity_capacity; ++id)
+    {
+      relevant_stamps[id] = 0;
+      visit_stamps[id]    = 0;
+    }
+  }
+
+  template<typename p_ids_per_tile, int p_width, int p_height>
+  void update(const int center_tile_index, const tile_map<p_width,p_height>& p_tile_map, const p_ids_per_tile& p_tile_to_entities)  // call every STATE after the tile buckets are updated
+  {
+    const std::uint32_t previous_update = update_count;
+    ++update_count;
+    relevant_count = 0;
+
+    const int center_x = center_tile_index % p_tile_map.width;
+    const int center_y = center_tile_index / p_tile_map.width;
+
+    // only the view plus the hysteresis border is scanned, entities outside it are dropped by not being listed
+    const int left   = ( (center_x - INTEREST_VIEW_HALF_WIDTH  - INTEREST_HYSTERESIS_TILES) > 0 ) ? (center_x - INTEREST_VIEW_HALF_WIDTH  - INTEREST_HYSTERESIS_TILES) : 0;
+    const int top    = ( (center_y - INTEREST_VIEW_HALF_HEIGHT - INTEREST_HYSTERESIS_TILES) > 0 ) ? (center_y - INTEREST_VIEW_HALF_HEIGHT - INTEREST_HYSTERESIS_TILES) : 0;
+    const int right  = ( (center_x + INTEREST_VIEW_HALF_WIDTH  + INTEREST_HYSTERESIS_TILES) < p_tile_map.width  ) ? (center_x + INTEREST_VIEW_HALF_WIDTH  + INTEREST_HYSTERESIS_TILES) : (p_tile_map.width - 1);
+    const int bottom = ( (center_y + INTEREST_VIEW_HALF_HEIGHT + INTEREST_HYSTERESIS_TILES) < p_tile_map.height ) ? (center_y + INTEREST_VIEW_HALF_HEIGHT + INTEREST_HYSTERESIS_TILES) : (p_tile_map.height - 1);
+
+    for(int y=top; y <= bottom; ++y)
+    {
+      const bool is_row_in_view = std::abs(y - center_y) <= INTEREST_VIEW_HALF_HEIGHT;
+
+      for(int x=left; x <= right; ++x)
+      {
+        const bool is_in_view = is_row_in_view && (std::abs(x - center_x) <= INTEREST_VIEW_HALF_WIDTH);
+
+        for(const int id : p_tile_to_entities.bucket((y * p_tile_map.width) + x))
+        {
+          if (visit_stamps[id] == update_count) continue;
+          if ( !is_in_view && (relevant_stamps[id] != previous_update) ) continue;  // may still be in view through another of its tiles
+
+          visit_stamps[id]    = update_count;
+          relevant_stamps[id] = update_count;
+          relevant_ids[relevant_count] = id;
+          ++relevant_count;
+        }
+      }
+    }
+  }
+};
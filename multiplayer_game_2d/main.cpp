@@ -1,381 +1,369 @@
-#include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
-#include <iostream>
-#include <string.h>
-#include <windows.h>
-#include <bitset>
-#include <cmath>
-#include <cstdlib>
-#include <time.h>
-#include <assert.h>
-#include <limits>
-#include "gameplay.h"
-
-
-#pragma warning(disable : 26812)  // allow unscoped enums becasue SFML uses them
-
-// @remember: test with range of resolutions
-// @current: review and refactor code
-
-
-// @optimize: should decrease MAX_ENTITIES_PER_TILE when game is finished or when related design decisions are final
-#define TILE_MAP_WIDTH              17
-#define TILE_MAP_HEIGHT             11
-#define TILE_COUNT                  (TILE_MAP_WIDTH * TILE_MAP_HEIGHT)
-#define MAX_GAMEPLAY_ENTITIES       TILE_COUNT
-#define TILE_MAP_TEXTURE_SIDE_SIZE  64                                  // in pixels
-#define MAX_ENTITIES_PER_TILE       10                                  // potential game object count in an single tile
-
-
-
-int main()
-{
-  /* create window */
-  sf::VideoMode desktop_video_mode = sf::VideoMode::getDesktopMode();
-  sf::RenderWindow window(desktop_video_mode, "2D Multiplayer Game", sf::Style::Fullscreen);
-  //window.setVerticalSyncEnabled(true);
-  window.setActive(true);
-  sf::Vector2u window_size = window.getSize();
-
-  sf::SoundBuffer tingling_sound_buffer;
-  tingling_sound_buffer.loadFromFile("Assets/Sounds/tingling.wav");
-  sf::Sound tingling;
-  tingling.setBuffer(tingling_sound_buffer);
-  
-  tile_map<TILE_MAP_WIDTH,TILE_MAP_HEIGHT>* test_tile_map = new tile_map<TILE_MAP_WIDTH,TILE_MAP_HEIGHT>("Assets/Images/test_tile_map.png", (float) window_size.x, (float) window_size.y, TILE_MAP_TEXTURE_SIDE_SIZE);
-
-  // generate walls
-  for(int i=0; i < test_tile_map->width; ++i)
-  {
-    test_tile_map->bitmap[i] = static_cast<int>(tile_map_bitmap_type::WALL);
-  }
-
-  for(int i=0; i < test_tile_map->height; ++i)
-  {
-    test_tile_map->bitmap[i * test_tile_map->width] = static_cast<int>(tile_map_bitmap_type::WALL);
-  }
-
-  for(int i=(test_tile_map->tile_count - test_tile_map->width); i < test_tile_map->tile_count; ++i)
-  {
-    test_tile_map->bitmap[i] = static_cast<int>(tile_map_bitmap_type::WALL);
-  }
-
-  for(int i=1; i < test_tile_map->height; ++i)
-  {
-    test_tile_map->bitmap[(i * test_tile_map->width) + (test_tile_map->width - 1)] = static_cast<int>(tile_map_bitmap_type::WALL);
-  }
-
-  for(int tile_index = (test_tile_map->width * 2); tile_index < test_tile_map->tile_count; tile_index += (test_tile_map->width * 2))
-  {
-    for(int tile_index_offset=1; tile_index_offset < test_tile_map->width; ++tile_index_offset)
-    {
-      if (tile_index_offset % 2 == 0)
-        test_tile_map->bitmap[tile_index + tile_index_offset] = static_cast<int>(tile_map_bitmap_type::WALL);
-    }
-  }
-
-  // create tile_map triggers
-  test_tile_map->bitmap[18] = static_cast<int>(tile_map_bitmap_type::TEST);
-  test_tile_map->bitmap[45] = static_cast<int>(tile_map_bitmap_type::TEST);
-  test_tile_map->bitmap[63] = static_cast<int>(tile_map_bitmap_type::TEST);
-  test_tile_map->bitmap[99] = static_cast<int>(tile_map_bitmap_type::TEST);
-
-  gameplay_entities<MAX_GAMEPLAY_ENTITIES>* all_gameplay_entities = new gameplay_entities<MAX_GAMEPLAY_ENTITIES>("Assets/Images/gameplay_entities.png", TILE_MAP_TEXTURE_SIDE_SIZE * 3); // need to be able to handle a single gameplay entity per tile
-  gameplay_entity_ids_per_tile<TILE_MAP_WIDTH,TILE_MAP_HEIGHT,MAX_GAMEPLAY_ENTITIES,MAX_ENTITIES_PER_TILE>* tile_to_gameplay_entities = new gameplay_entity_ids_per_tile<TILE_MAP_WIDTH,TILE_MAP_HEIGHT,MAX_GAMEPLAY_ENTITIES,MAX_ENTITIES_PER_TILE>();
-
-
-  #ifdef _DEBUG
-    bool show_debug_data = true;
-    sf::Font mandalore_font;
-    mandalore_font.loadFromFile("Assets/Fonts/mandalore.ttf");
-
-    static sf::Text tile_index_text[TILE_MAP_WIDTH * TILE_MAP_HEIGHT];
-    test_tile_map->generate_debug_tile_index_text(tile_index_text, mandalore_font, sf::Color::Blue);
-    static sf::Text game_entity_index_text[MAX_GAMEPLAY_ENTITIES];
-  #endif
-  
-  all_gameplay_entities->is_garbage_flags[0]  = false;
-  all_gameplay_entities->is_garbage_flags[1]  = false;
-  all_gameplay_entities->is_garbage_flags[2]  = false;
-  all_gameplay_entities->is_garbage_flags[3]  = false;
-  all_gameplay_entities->is_garbage_flags[4]  = false;
-  all_gameplay_entities->is_garbage_flags[5]  = false;
-  all_gameplay_entities->is_garbage_flags[6]  = false;
-  all_gameplay_entities->is_garbage_flags[7]  = false;
-  all_gameplay_entities->is_garbage_flags[8]  = false;
-  all_gameplay_entities->is_garbage_flags[9]  = false;
-  all_gameplay_entities->is_garbage_flags[10] = false;
-  all_gameplay_entities->is_garbage_flags[11] = false;
-  all_gameplay_entities->is_garbage_flags[12] = false;
-  all_gameplay_entities->is_garbage_flags[13] = false;
-  all_gameplay_entities->is_garbage_flags[14] = false;
-  all_gameplay_entities->is_garbage_flags[15] = false;
-  all_gameplay_entities->is_garbage_flags[16] = false;
-  all_gameplay_entities->is_garbage_flags[17] = false;
-  all_gameplay_entities->is_garbage_flags[18] = false;
-  all_gameplay_entities->is_garbage_flags[19] = false;
-
-
-  all_gameplay_entities->types[0] = gameplay_entity_type::MARIO;
-  all_gameplay_entities->types[1] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[2] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[3] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[4] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[5] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[6] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[7] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[8] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[9] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[10] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[11] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[12] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[13] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[14] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[14] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[15] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[16] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[17] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[18] = gameplay_entity_type::BOMB;
-  all_gameplay_entities->types[19] = gameplay_entity_type::BOMB;
- 
-  all_gameplay_entities->animation_indexes[0] = 0;
-  all_gameplay_entities->animation_indexes[1] = 0;
-  all_gameplay_entities->animation_indexes[2] = 0;
-
-  // initialize entity positions to (0,0) origin
-  for(int i=0; i < all_gameplay_entities->vertex_count; i+=4)
-  {
-    all_gameplay_entities->vertex_buffer[i].position   = sf::Vector2f(-test_tile_map->tile_size_x, -test_tile_map->tile_size_y * 2);
-    all_gameplay_entities->vertex_buffer[i+1].position = sf::Vector2f(2 * test_tile_map->tile_size_x, -test_tile_map->tile_size_y * 2);
-    all_gameplay_entities->vertex_buffer[i+2].position = sf::Vector2f(test_tile_map->tile_size_x * 2, test_tile_map->tile_size_y);
-    all_gameplay_entities->vertex_buffer[i+3].position = sf::Vector2f(-test_tile_map->tile_size_x, test_tile_map->tile_size_y);
-  }
-
-  // initialize default collision rectangles
-  for(int i=0; i < all_gameplay_entities->vertex_count; i+=4)
-  {
-    // the tile_size - 0.01f is to currently handle overlapping tile vertices
-    all_gameplay_entities->collision_vertices[i]   = sf::Vector2f(1.0f, 1.0f);
-    all_gameplay_entities->collision_vertices[i+1] = sf::Vector2f(test_tile_map->tile_size_x - 1.0f, 1.0f);
-    all_gameplay_entities->collision_vertices[i+2] = sf::Vector2f(test_tile_map->tile_size_x - 1.0f, test_tile_map->tile_size_y - 1.0f);
-    all_gameplay_entities->collision_vertices[i+3] = sf::Vector2f(1.0f, test_tile_map->tile_size_y - 1.0f);
-  }
-
-  // set spawn positions
-  all_gameplay_entities->update_position_by_offset( 0, sf::Vector2f(test_tile_map->tile_size_x * 2, 3 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 1, sf::Vector2f(test_tile_map->tile_size_x * 4, 5 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 2, sf::Vector2f(test_tile_map->tile_size_x * 6, 7 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 3, sf::Vector2f(test_tile_map->tile_size_x * 8, 3 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 4, sf::Vector2f(test_tile_map->tile_size_x * 3, 7 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 5, sf::Vector2f(test_tile_map->tile_size_x * 4, 7 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 6, sf::Vector2f(test_tile_map->tile_size_x * 7, 8 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 7, sf::Vector2f(test_tile_map->tile_size_x * 6, 9 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 8, sf::Vector2f(test_tile_map->tile_size_x * 11, 6 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 9, sf::Vector2f(test_tile_map->tile_size_x * 9, 4 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 10, sf::Vector2f(test_tile_map->tile_size_x * 2, 9 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 11, sf::Vector2f(test_tile_map->tile_size_x * 5, 4 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 12, sf::Vector2f(test_tile_map->tile_size_x * 13, 8 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 13, sf::Vector2f(test_tile_map->tile_size_x * 8, 5 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 14, sf::Vector2f(test_tile_map->tile_size_x * 4, 9 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 15, sf::Vector2f(test_tile_map->tile_size_x * 7, 3 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 16, sf::Vector2f(test_tile_map->tile_size_x * 6, 5 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 17, sf::Vector2f(test_tile_map->tile_size_x * 5, 9 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 18, sf::Vector2f(test_tile_map->tile_size_x * 5, 7 * test_tile_map->tile_size_y) );
-  all_gameplay_entities->update_position_by_offset( 19, sf::Vector2f(test_tile_map->tile_size_x * 5, 1 * test_tile_map->tile_size_y) );
-
-
-  // initialize gameplay_entity moves
-  gameplay_entity_moves<MAX_GAMEPLAY_ENTITIES,TILE_MAP_WIDTH,TILE_MAP_HEIGHT>* all_entity_moves = new gameplay_entity_moves<MAX_GAMEPLAY_ENTITIES,TILE_MAP_WIDTH,TILE_MAP_HEIGHT>( all_gameplay_entities->all_collision_vertices_origin_positions(), all_gameplay_entities->is_garbage_flags, *test_tile_map);
-  gameplay_entity_move_request* all_move_requests = new gameplay_entity_move_request[MAX_GAMEPLAY_ENTITIES];
-  gameplay_entity_move_request player_move_request;
-
-
-
-  /* setup and run game loop */
-  sf::Event window_event;
-  sf::Clock clock;
-  sf::Time  elapsed_frame_time;
-  sf::Int32 elapsed_frame_time_milliseconds;
-  sf::Int64 elapsed_frame_time_microseconds;
-  float     elapsed_frame_time_seconds;
-
-  srand(static_cast<unsigned int>(time(NULL))); // @optimize: randomn values should probably be pre-generated or at least only generated once
-
-
-  while (window.isOpen())
-  {
-    // determine framerate
-    elapsed_frame_time = clock.restart();
-    elapsed_frame_time_milliseconds = elapsed_frame_time.asMilliseconds();
-    elapsed_frame_time_microseconds = elapsed_frame_time.asMicroseconds();
-    elapsed_frame_time_seconds      = elapsed_frame_time.asSeconds();
-
-    #ifdef _DEBUG
-      if ( (elapsed_frame_time_milliseconds > 16) && show_debug_data)
-        std::cout << "elapsed_frame_time_milliseconds: " << elapsed_frame_time_milliseconds << std::endl;
-    #endif
-
-    // reset all move requests by setting request velocities to (0,0)
-    for (int i = 0; i < MAX_GAMEPLAY_ENTITIES; ++i) all_move_requests[i].velocity = sf::Vector2f(0.0f,0.0f);
-
-
-
-    /* get input and events */
-    while (window.pollEvent(window_event))
-    {
-      switch (window_event.type)
-      {
-        case sf::Event::Closed:
-              window.close();
-              break;
-
-        case sf::Event::KeyPressed:
-              if (window_event.key.code == sf::Keyboard::P) all_gameplay_entities->animation_indexes[1] = (all_gameplay_entities->animation_indexes[1] + 1) % 3;
-              break;
-
-        case sf::Event::KeyReleased:
-              #ifdef _DEBUG
-                if ( window_event.key.code == sf::Keyboard::D ) show_debug_data = !show_debug_data;
-                //if ( window_event.key.code == sf::Keyboard::P ) tile_to_gameplay_entities->print_tile_buckets();
-              #endif
-
-              break;
-
-        default:
-              break;
-      }
-    }
-
-    if      (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))   player_move_request.velocity = sf::Vector2f( (float) -3 * test_tile_map->tile_size_x, 0.0f );
-    else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))  player_move_request.velocity = sf::Vector2f( (float) 3 * test_tile_map->tile_size_x, 0.0f  );
-    else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up))     player_move_request.velocity = sf::Vector2f( 0.0f, (float) -3 * test_tile_map->tile_size_y );
-    else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down))   player_move_request.velocity = sf::Vector2f( 0.0f, (float)  3 * test_tile_map->tile_size_y );
-
-
-
-    /* calculate gameplay stuff */
-    player_move_request.current_origin_position = all_gameplay_entities->collision_vertices[0];
-
-    // if already moving and passed distance threshold then chamber move else if already moving do nothing else if stationary then move player
-    if ( (all_entity_moves->velocities[0].x && (std::abs(all_entity_moves->destination_origin_positions[0].x - all_entity_moves->current_origin_positions[0].x) >= (test_tile_map->tile_size_x / 3.0f)) ) ||
-         (all_entity_moves->velocities[0].y && (std::abs(all_entity_moves->destination_origin_positions[0].y - all_entity_moves->current_origin_positions[0].y) >= (test_tile_map->tile_size_y / 3.0f)) ) )
-    {
-      if (player_move_request.velocity.x > 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(test_tile_map->tile_size_x,0.0f);
-      if (player_move_request.velocity.x < 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(-1.0f * test_tile_map->tile_size_x, 0.0f);
-      if (player_move_request.velocity.y > 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(0.0f,test_tile_map->tile_size_y);
-      if (player_move_request.velocity.y < 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(0.0f,-1.0f * test_tile_map->tile_size_y);
-
-      if (player_move_request.velocity.x || player_move_request.velocity.y)
-      {
-        all_move_requests[0] = player_move_request;
-      }
-    }
-    else if ( !(all_entity_moves->velocities[0].x) && !(all_entity_moves->velocities[0].y))
-    {
-      if (player_move_request.velocity.x > 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(test_tile_map->tile_size_x,0.0f);
-      if (player_move_request.velocity.x < 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(-1.0f * test_tile_map->tile_size_x, 0.0f);
-      if (player_move_request.velocity.y > 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(0.0f,test_tile_map->tile_size_y);
-      if (player_move_request.velocity.y < 0) player_move_request.destination_origin_position = player_move_request.current_origin_position + sf::Vector2f(0.0f,-1.0f * test_tile_map->tile_size_y);
-
-      if (player_move_request.velocity.x || player_move_request.velocity.y)
-      {
-        all_move_requests[0] = player_move_request;
-      }
-    }
-    else player_move_request.velocity = sf::Vector2f(0.0f, 0.0f); // reset chamber
- 
-
-    // generate test movement requests
-    generate_move_request_input stress_test_move_requests[MAX_GAMEPLAY_ENTITIES];
-    for(int i=0; i < 14; ++i)
-    {
-      int random_number = (rand() % 10 + 1);
-      stress_test_move_requests[i].gameplay_entity_id = (i+1);
-
-      float x = 0.0f;
-      float y = 0.0f;
-      // decide axis
-      (random_number > 5) ? x = 1.0f : y = 1.0f;
-
-      // decide sign
-      random_number = (rand() % 10 + 1);
-      if(random_number > 5) { x *= -1.0f; y *= -1.0f; }
-
-      // decide magnitude
-      random_number = 10;//(rand() % 10 + 1);
-      x *= ( static_cast<float>(random_number) * 25.0f);
-      y *= ( static_cast<float>(random_number) * 25.0f);
-
-      stress_test_move_requests[i].velocity = sf::Vector2f(x,y);
-    }
-    all_gameplay_entities->generate_move_requests(stress_test_move_requests,all_move_requests, 14,test_tile_map->tile_size_x,test_tile_map->tile_size_y);
-
-
-    // update movement
-    all_entity_moves->submit_all_moves(all_move_requests, *test_tile_map, all_gameplay_entities->is_garbage_flags);
-    all_entity_moves->update_by_velocities(elapsed_frame_time_seconds, *test_tile_map);
-    all_gameplay_entities->set_all_positions(all_entity_moves->current_origin_positions);
-
-
-    // sort gameplay entities by tile
-    tile_to_gameplay_entities->update(*test_tile_map, *all_gameplay_entities);
-
-
-    // activate tile_map triggers
-    for(int tile_index=0; tile_index < test_tile_map->tile_count; ++tile_index)
-    {
-      int gameplay_entity_id;
-      switch ( static_cast<tile_map_bitmap_type>(test_tile_map->bitmap[tile_index]) )
-      {
-        case tile_map_bitmap_type::TEST:
-             gameplay_entity_id = tile_to_gameplay_entities->tile_buckets[tile_index * MAX_ENTITIES_PER_TILE];
-
-             if(gameplay_entity_id != -1)
-             {
-               all_gameplay_entities->animation_indexes[gameplay_entity_id] = (all_gameplay_entities->animation_indexes[gameplay_entity_id ] + 1) % 3;
-               tingling.play();
-               test_tile_map->bitmap[tile_index] = 0;
-             }
-             break;
-
-        default:
-             break;
-      }
-    }
-
-
-
-    /* draw */
-    test_tile_map->update_tex_coords_from_bitmap();
-    all_gameplay_entities->update_tex_coords(elapsed_frame_time_seconds);
-
-    window.clear(sf::Color::Black);
-    window.draw(test_tile_map->vertex_buffer, test_tile_map->vertex_count, sf::Quads, &test_tile_map->tiles_texture);
-    window.draw(all_gameplay_entities->vertex_buffer, all_gameplay_entities->vertex_count, sf::Quads, &all_gameplay_entities->sprite_sheet_texture);
-
-    #ifdef _DEBUG
-      if(show_debug_data)
-      {
-        window.draw( *(test_tile_map->generate_debug_line_vertices(sf::Color::Blue))                  );
-        window.draw( *(all_gameplay_entities->generate_debug_collision_line_vertices(sf::Color::Red)) );
-        //window.draw( *(all_gameplay_entities->generate_debug_line_vertices(sf::Color::Yellow))        );
-
-        for(auto& text : tile_index_text) window.draw(text);
-
-        all_gameplay_entities->generate_debug_index_text(game_entity_index_text, mandalore_font, sf::Color::Yellow);
-        for(auto& text : game_entity_index_text) window.draw(text);
-      }
-    #endif
-
-    // draw HUD (if decided to have static HUD)
-    // draw options if requested
-
-    window.display();
-
-
-
-    if (elapsed_frame_time_seconds == 0.0f) Sleep(1);
-  } // end of game loop
-
-  return 0;
-}
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include <iostream>
+#include <string.h>
+#include "net.h"        // before <windows.h>, see net.h
+#include <windows.h>
+#include <bitset>
+#include <cmath>
+#include <cstdlib>
+#include <time.h>
+#include <assert.h>
+#include <limits>
+#include "gameplay.h"
+#include "gameplay_render.h"
+#include "arena.h"
+#include "match.h"
+#include "replay.h"
+#include "fixed_timestep.h"
+#include "protocol.h"
+#include "net_client.h"
+#include "profiler.h"
+#include "movement_stats.h"
+
+
+#pragma warning(disable : 26812)  // allow unscoped enums becasue SFML uses them
+
+// @remember: test with range of resolutions
+// @current: review and refactor code
+// @remember: "main <server_ip> [port]" joins a server (see server.cpp) instead of running the simulation locally
+// @remember: "main [--seed <seed>] [--record <file>]" runs it locally, the seed is printed at startup and a recording plays back with "server replay <file>"
+// @remember: the local simulation is a match (see match.h) with tiles sized to the window, the game only adds the player, sound and rendering
+
+
+#define TILE_MAP_TEXTURE_SIDE_SIZE  64                                  // in pixels
+#define SIMULATION_TICK_RATE        60                                  // simulation ticks per second, rendering runs at whatever rate the display allows
+#define MAX_TICKS_PER_FRAME         5                                   // bounded catch-up after a stall
+
+
+
+int main(int argc, char** argv)
+{
+  const bool is_networked = (argc > 1) && (argv[1][0] != '-');
+  profiler_name_thread("main");
+
+  unsigned int seed        = static_cast<unsigned int>(time(NULL));
+  const char*  record_path = nullptr;
+  if (!is_networked)
+  {
+    for(int i=1; i + 1 < argc; i += 2)
+    {
+      if      (strcmp(argv[i], "--seed")   == 0) seed        = static_cast<unsigned int>(atoi(argv[i+1]));
+      else if (strcmp(argv[i], "--record") == 0) record_path = argv[i+1];
+    }
+    std::cout << "game seed " << seed << std::endl;
+  }
+
+  /* create window */
+  sf::VideoMode desktop_video_mode = sf::VideoMode::getDesktopMode();
+  sf::RenderWindow window(desktop_video_mode, "2D Multiplayer Game", sf::Style::Fullscreen);
+  //window.setVerticalSyncEnabled(true);
+  window.setActive(true);
+  sf::Vector2u window_size = window.getSize();
+
+  sf::SoundBuffer tingling_sound_buffer;
+  tingling_sound_buffer.loadFromFile("Assets/Sounds/tingling.wav");
+  sf::Sound tingling;
+  tingling.setBuffer(tingling_sound_buffer);
+  
+  // when networked the server owns the simulation, the entities and bitmap are mirrored from its STATE packets
+  typedef match<TILE_MAP_WIDTH,TILE_MAP_HEIGHT,MAX_GAMEPLAY_ENTITIES> game_match;
+  const float tile_size_x = (float) window_size.x / TILE_MAP_WIDTH;
+  const float tile_size_y = (float) window_size.y / TILE_MAP_HEIGHT;
+  game_match* game = is_networked ? nullptr : new game_match(TILE_MAP_WIDTH, TILE_MAP_HEIGHT, seed, tile_size_x, tile_size_y);
+
+  replay_writer recorder;
+  if (record_path)
+  {
+    replay_header header;
+    header.map_width       = TILE_MAP_WIDTH;
+    header.map_height      = TILE_MAP_HEIGHT;
+    header.entity_capacity = MAX_GAMEPLAY_ENTITIES;
+    header.tick_rate       = SIMULATION_TICK_RATE;
+    header.seed            = seed;
+    header.tile_size_x     = tile_size_x;
+    header.tile_size_y     = tile_size_y;
+
+    if ( !recorder.open(record_path, header) )
+    {
+      std::cout << "could not open " << record_path << " for recording" << std::endl;
+      return 1;
+    }
+    game->recorder = &recorder;
+  }
+
+  tile_map<TILE_MAP_WIDTH,TILE_MAP_HEIGHT>* test_tile_map = game ? game->test_tile_map : new tile_map<TILE_MAP_WIDTH,TILE_MAP_HEIGHT>((float) window_size.x, (float) window_size.y);
+  tile_map_sprites<TILE_MAP_WIDTH,TILE_MAP_HEIGHT>* test_tile_map_sprites = new tile_map_sprites<TILE_MAP_WIDTH,TILE_MAP_HEIGHT>("Assets/Images/test_tile_map.png", *test_tile_map, TILE_MAP_TEXTURE_SIDE_SIZE);
+  if (is_networked) generate_test_arena_bitmap(*test_tile_map);  // drawn until the first STATE arrives
+
+  gameplay_entities<MAX_GAMEPLAY_ENTITIES>* all_gameplay_entities = game ? game->all_gameplay_entities : new gameplay_entities<MAX_GAMEPLAY_ENTITIES>(); // need to be able to handle a single gameplay entity per tile
+  gameplay_entity_sprites<MAX_GAMEPLAY_ENTITIES>* all_gameplay_entity_sprites = new gameplay_entity_sprites<MAX_GAMEPLAY_ENTITIES>("Assets/Images/gameplay_entities.png", TILE_MAP_TEXTURE_SIDE_SIZE * 3);
+  replicated_entities<MAX_GAMEPLAY_ENTITIES>* replicated_gameplay_entities = is_networked ? new replicated_entities<MAX_GAMEPLAY_ENTITIES>() : nullptr;
+  snapshot_interpolation<MAX_GAMEPLAY_ENTITIES>* interpolated_gameplay_entities = is_networked ? new snapshot_interpolation<MAX_GAMEPLAY_ENTITIES>() : nullptr;  // remote entities are drawn a little in the past so they move smoothly
+
+
+  #ifdef _DEBUG
+    bool show_debug_data = true;
+    sf::Font mandalore_font;
+    mandalore_font.loadFromFile("Assets/Fonts/mandalore.ttf");
+
+    static sf::Text tile_index_text[TILE_MAP_WIDTH * TILE_MAP_HEIGHT];
+    test_tile_map_sprites->generate_debug_tile_index_text(*test_tile_map, tile_index_text, mandalore_font, sf::Color::Blue);
+    static sf::Text game_entity_index_text[MAX_GAMEPLAY_ENTITIES];
+  #endif
+
+
+  // initialize sprite vertices relative to entity origin (the collision origin is inset by 1.0f)
+  for(int i=0; i < all_gameplay_entity_sprites->vertex_count; i+=4)
+  {
+    all_gameplay_entity_sprites->sprite_vertex_offsets[i]   = sf::Vector2f(-test_tile_map->tile_size_x - 1.0f, (-test_tile_map->tile_size_y * 2) - 1.0f);
+    all_gameplay_entity_sprites->sprite_vertex_offsets[i+1] = sf::Vector2f((2 * test_tile_map->tile_size_x) - 1.0f, (-test_tile_map->tile_size_y * 2) - 1.0f);
+    all_gameplay_entity_sprites->sprite_vertex_offsets[i+2] = sf::Vector2f((test_tile_map->tile_size_x * 2) - 1.0f, test_tile_map->tile_size_y - 1.0f);
+    all_gameplay_entity_sprites->sprite_vertex_offsets[i+3] = sf::Vector2f(-test_tile_map->tile_size_x - 1.0f, test_tile_map->tile_size_y - 1.0f);
+  }
+
+
+  // initialize player input
+  player_move_chamber player_chamber;
+  player_input_direction player_direction;
+
+  // origin positions from the previous tick so rendering can interpolate between ticks
+  sf::Vector2f* previous_origin_positions     = new sf::Vector2f[MAX_GAMEPLAY_ENTITIES];
+  sf::Vector2f* interpolated_origin_positions = new sf::Vector2f[MAX_GAMEPLAY_ENTITIES];
+  if (game) for(int id=0; id < MAX_GAMEPLAY_ENTITIES; ++id) previous_origin_positions[id] = game->all_entity_moves->current_origin_position(id);
+
+
+
+  /* setup and run game loop */
+  sf::Event window_event;
+  sf::Clock clock;
+  sf::Time  elapsed_frame_time;
+  sf::Int64 elapsed_frame_time_microseconds;
+  float     elapsed_frame_time_seconds;
+  fixed_timestep_scheduler simulation_scheduler(SIMULATION_TICK_RATE, MAX_TICKS_PER_FRAME);
+
+  latency_histogram*    frame_times = new latency_histogram();      // in us, the spikes an average FPS hides
+  tick_time_histograms* timings     = new tick_time_histograms();   // local simulation systems, in profiler ticks
+  float seconds_since_histogram_report = 0.0f;
+  if (game) game->timings = timings;
+
+  net_client* client = nullptr;
+  fixed_timestep_scheduler* network_scheduler = nullptr;                                                          // ticks at the server's tick rate so every input is one server tick
+  player_prediction<MAX_GAMEPLAY_ENTITIES,TILE_MAP_WIDTH,TILE_MAP_HEIGHT>* prediction = nullptr;                 // the local player runs ahead of the server
+  if (is_networked)
+  {
+    const int server_port = (argc > 2) ? atoi(argv[2]) : DEFAULT_SERVER_PORT;
+    client = new net_client();
+
+    if ( !net_startup() || !client->start(argv[1], static_cast<std::uint16_t>(server_port)) )
+    {
+      std::cout << "could not start client for " << argv[1] << ":" << server_port << std::endl;
+      return 1;
+    }
+  }
+
+
+  while (window.isOpen())
+  {
+    // determine framerate
+    elapsed_frame_time = clock.restart();
+    elapsed_frame_time_microseconds = elapsed_frame_time.asMicroseconds();
+    elapsed_frame_time_seconds      = elapsed_frame_time.asSeconds();
+
+    frame_times->record( static_cast<std::uint64_t>(elapsed_frame_time_microseconds) );
+    seconds_since_histogram_report += elapsed_frame_time_seconds;
+    if (seconds_since_histogram_report >= HISTOGRAM_REPORT_SECONDS)
+    {
+      frame_times->print("game", "frame", 1.0);
+      if (!is_networked) timings->print("game", profiler_microseconds_per_tick());  // networked clients don't simulate
+      if (!is_networked) game->current_movement_stats().print("game");
+      seconds_since_histogram_report = 0.0f;
+    }
+
+    int tick_count_this_frame = is_networked ? 0 : simulation_scheduler.advance(elapsed_frame_time_seconds);  // networked clients tick with network_scheduler once connected
+
+
+
+    /* get input and events */
+    {
+      PROFILE_ZONE("input");
+
+      while (window.pollEvent(window_event))
+      {
+        switch (window_event.type)
+        {
+          case sf::Event::Closed:
+                window.close();
+                break;
+
+          case sf::Event::KeyPressed:
+                if (window_event.key.code == sf::Keyboard::P) all_gameplay_entities->animation_indexes[1] = (all_gameplay_entities->animation_indexes[1] + 1) % 3;
+                break;
+
+          case sf::Event::KeyReleased:
+                #ifdef _DEBUG
+                  if ( window_event.key.code == sf::Keyboard::D ) show_debug_data = !show_debug_data;
+                  //if ( window_event.key.code == sf::Keyboard::P ) game->tile_to_gameplay_entities->print_tile_buckets();
+                #endif
+
+                break;
+
+          default:
+                break;
+        }
+      }
+
+      if      (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))   player_direction = player_input_direction::LEFT;
+      else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))  player_direction = player_input_direction::RIGHT;
+      else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up))     player_direction = player_input_direction::UP;
+      else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down))   player_direction = player_input_direction::DOWN;
+      else                                                       player_direction = player_input_direction::NONE;
+    }
+
+
+
+    /* get server state */
+    if (is_networked)
+    {
+      PROFILE_ZONE("server state");
+
+      client->update(elapsed_frame_time_seconds);
+      interpolated_gameplay_entities->advance(elapsed_frame_time_seconds);
+
+      if ( (client->state == net_client_state::DISCONNECTED) || (client->state == net_client_state::DENIED) )
+      {
+        std::cout << "lost connection to server" << std::endl;
+        window.close();
+        break;
+      }
+
+      // positions arrive in tiles so the map dimensions have to match, the tile size doesn't
+      if ( (client->state == net_client_state::CONNECTED) && ((client->accept.map_width != TILE_MAP_WIDTH) || (client->accept.map_height != TILE_MAP_HEIGHT)) )
+      {
+        std::cout << "server map is " << client->accept.map_width << "x" << client->accept.map_height << " but this client is built for " << TILE_MAP_WIDTH << "x" << TILE_MAP_HEIGHT << std::endl;
+        window.close();
+        break;
+      }
+
+      if ( (client->state == net_client_state::CONNECTED) && !network_scheduler )
+      {
+        network_scheduler = new fixed_timestep_scheduler(client->accept.tick_rate, MAX_TICKS_PER_FRAME);
+        prediction        = new player_prediction<MAX_GAMEPLAY_ENTITIES,TILE_MAP_WIDTH,TILE_MAP_HEIGHT>(*test_tile_map);
+        prediction->player_id = client->accept.entity_id;
+      }
+
+      if (client->has_new_state)
+      {
+        replicated_gameplay_entities->apply(client->latest_state, *test_tile_map, *all_gameplay_entities);
+        prediction->reconcile(client->latest_state, client->latest_acked_input_sequence, client->latest_acked_chamber_direction, *test_tile_map, network_scheduler->tick_seconds);
+        interpolated_gameplay_entities->push(client->latest_state, network_scheduler->tick_seconds, *test_tile_map);
+        client->has_new_state = false;
+      }
+
+      if (network_scheduler) tick_count_this_frame = network_scheduler->advance(elapsed_frame_time_seconds);
+    }
+
+
+
+    /* calculate gameplay stuff */
+    for(int tick=0; tick < tick_count_this_frame; ++tick)
+    {
+      // the server simulates, the client sends what is held and predicts its own player
+      if (is_networked)
+      {
+        std::uint32_t sequence = client->send_input(player_direction);
+        if (prediction->has_player()) previous_origin_positions[prediction->player_id] = prediction->player_origin_position();
+        prediction->step(sequence, player_direction, *test_tile_map, network_scheduler->tick_seconds);
+        continue;
+      }
+
+      // only live entities are read by the systems so only their slots need copying
+      for(int live_index=0; live_index < all_gameplay_entities->live_count; ++live_index)
+      {
+        int id = all_gameplay_entities->live_ids[live_index];
+        previous_origin_positions[id] = game->all_entity_moves->current_origin_position(id);
+      }
+
+      const int triggered_count_before = game->triggered_count;
+      game->tick(simulation_scheduler.tick_seconds, [&](game_match& p_match)
+      {
+        player_chamber.hold(player_direction);
+        player_chamber.generate_move_request(0, *p_match.all_gameplay_entities, *p_match.all_entity_moves, *p_match.test_tile_map, p_match.all_move_requests);
+      });
+      if (game->triggered_count != triggered_count_before) tingling.play();
+    } // end of simulation ticks
+
+
+
+    /* draw */
+    {
+      PROFILE_ZONE("tex coords");
+
+      test_tile_map_sprites->update_tex_coords_from_bitmap(*test_tile_map);
+      if (is_networked)
+      {
+        interpolated_gameplay_entities->sample(*all_gameplay_entities);
+        interpolate_origin_positions(previous_origin_positions, interpolated_gameplay_entities->origin_x, interpolated_gameplay_entities->origin_y, interpolated_origin_positions, all_gameplay_entities->live_ids, all_gameplay_entities->live_count, 1.0f);  // already interpolated between states
+      }
+      else              interpolate_origin_positions(previous_origin_positions, game->all_entity_moves->current_origin_x, game->all_entity_moves->current_origin_y, interpolated_origin_positions, all_gameplay_entities->live_ids, all_gameplay_entities->live_count, simulation_scheduler.interpolation_alpha());
+
+      // the local player is drawn where prediction has it instead of where the server last saw it
+      if ( prediction && prediction->has_player() && !all_gameplay_entities->is_garbage_flags[prediction->player_id] )
+      {
+        int player_id = prediction->player_id;
+        interpolated_origin_positions[player_id] = previous_origin_positions[player_id] + ((prediction->player_origin_position() - previous_origin_positions[player_id]) * network_scheduler->interpolation_alpha());
+      }
+      all_gameplay_entity_sprites->update_positions(*all_gameplay_entities, interpolated_origin_positions);
+      all_gameplay_entity_sprites->update_tex_coords(*all_gameplay_entities, elapsed_frame_time_seconds);
+    }
+
+    {
+      PROFILE_ZONE("draw");
+
+      window.clear(sf::Color::Black);
+      window.draw(test_tile_map_sprites->vertex_buffer.data(), test_tile_map_sprites->vertex_count, sf::Quads, &test_tile_map_sprites->tiles_texture);
+      window.draw(all_gameplay_entity_sprites->vertex_buffer, all_gameplay_entity_sprites->drawn_vertex_count, sf::Quads, &all_gameplay_entity_sprites->sprite_sheet_texture);
+
+      #ifdef _DEBUG
+        if(show_debug_data)
+        {
+          window.draw( *(test_tile_map_sprites->generate_debug_line_vertices(sf::Color::Blue))                                                );
+          window.draw( *(all_gameplay_entity_sprites->generate_debug_collision_line_vertices(*all_gameplay_entities, sf::Color::Red)) );
+          //window.draw( *(all_gameplay_entity_sprites->generate_debug_line_vertices(*all_gameplay_entities, sf::Color::Yellow))        );
+
+          for(auto& text : tile_index_text) window.draw(text);
+
+          all_gameplay_entity_sprites->generate_debug_index_text(*all_gameplay_entities, game_entity_index_text, mandalore_font, sf::Color::Yellow);
+          for(auto& text : game_entity_index_text) window.draw(text);
+        }
+      #endif
+
+      // draw HUD (if decided to have static HUD)
+      // draw options if requested
+
+      window.display();
+    }
+  } // end of game loop
+
+  if (is_networked)
+  {
+    client->disconnect();
+    net_shutdown();
+
+    delete prediction;
+    delete network_scheduler;
+    delete interpolated_gameplay_entities;
+  }
+
+  frame_times->print("game", "frame", 1.0);
+  if (!is_networked) timings->print("game", profiler_microseconds_per_tick());
+  if (!is_networked) game->current_movement_stats().print("game");
+  delete timings;
+  delete frame_times;
+
+  if (recorder.is_open()) std::cout << "recorded " << recorder.record_count << " records (seed " << seed << ") to " << record_path << std::endl;
+  delete game;
+
+  write_chrome_trace_if_requested();
+  return 0;
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <random>
+#include <cstdint>
+#include <string.h>
+#include "gameplay.h"
+#include "arena.h"
+#include "replay.h"
+#include "state_hash.h"
+#include "profiler.h"
+#include "movement_stats.h"
+
+
+/*
+   @remember: everything one match simulates, matches share no memory (including the random generator) so any thread can tick one, one thread at a time
+   @remember: create a match on the thread that will tick it so its memory is first touched (and placed) by that core
+   @remember: spawn and despawn through the match (not its gameplay_entities) so a recorder sees them and the state hash follows, see replay.h
+   @remember: the state hash is updated as entities move, spawn and despawn and as tiles change (see state_hash.h), _DEBUG builds check it against a full rehash every tick
+*/
+
+
+#define MATCH_TILE_SIZE             64.0f   // default world units per tile, headless matches have no window to fit, the game passes its own
+#define MATCH_STRESS_MOVER_COUNT    14      // test arena entities 1 to 14 random walk
+#define MATCH_STRESS_MOVER_SPEED    250.0f
+
+
+
+/* match stuff */
+template<int p_width, int p_height, int p_max_gameplay_entities>
+struct match
+{
+  tile_map<p_width,p_height>*                                                                   test_tile_map;
+  tile_triggers<p_width,p_height>*                                                              test_tile_triggers;
+  gameplay_entities<p_max_gameplay_entities>*                                                   all_gameplay_entities;
+  gameplay_entity_ids_per_tile<p_width,p_height,p_max_gameplay_entities,MAX_ENTITIES_PER_TILE>* tile_to_gameplay_entities;
+  gameplay_entity_moves<p_max_gameplay_entities,p_width,p_height>*                              all_entity_moves;
+  gameplay_entity_move_request*                                                                 all_move_requests;
+
+  const unsigned int    seed;
+  std::minstd_rand      random_generator;
+  long long             tick_count      = 0;
+  int                   triggered_count = 0;
+  replay_writer*        recorder        = nullptr;   // not owned, records spawns, despawns and player move requests when set
+  tick_time_histograms* timings         = nullptr;   // not owned, gets every tick's per-system times when set, matches ticked by one thread can share one
+  movement_stats        movement;                    // the movement system's counters summed over every tick, read through current_movement_stats()
+
+  private:
+    std::uint64_t* entity_hashes;                  // each live entity's current hash, 0 for dead ones
+    std::uint64_t  entity_hash_sum = 0;
+    std::uint64_t  tile_hash_sum   = 0;
+  public:
+
+  match(const int map_width, const int map_height, const unsigned int p_seed, const float tile_size_x = MATCH_TILE_SIZE, const float tile_size_y = MATCH_TILE_SIZE) : seed(p_seed), random_generator(p_seed)
+  {
+    test_tile_map = new tile_map<p_width,p_height>(map_width, map_height, tile_size_x * map_width, tile_size_y * map_height);
+    generate_test_arena_bitmap(*test_tile_map);
+
+    test_tile_triggers = new tile_triggers<p_width,p_height>(*test_tile_map);
+    register_test_arena_triggers(*test_tile_triggers, *test_tile_map);
+
+    all_gameplay_entities     = new gameplay_entities<p_max_gameplay_entities>();
+    tile_to_gameplay_entities = new gameplay_entity_ids_per_tile<p_width,p_height,p_max_gameplay_entities,MAX_ENTITIES_PER_TILE>(*test_tile_map);
+    spawn_test_arena_entities(*all_gameplay_entities, *test_tile_map);
+    tile_to_gameplay_entities->update(*test_tile_map, *all_gameplay_entities);  // bin everything once, after that only moved entities are re-binned
+
+    all_entity_moves  = new gameplay_entity_moves<p_max_gameplay_entities,p_width,p_height>( all_gameplay_entities->all_collision_vertices_origin_positions(), all_gameplay_entities->is_garbage_flags, *test_tile_map);
+    all_move_requests = new gameplay_entity_move_request[p_max_gameplay_entities];
+
+    entity_hashes = new std::uint64_t[p_max_gameplay_entities];
+    for(int id=0; id < p_max_gameplay_entities; ++id) entity_hashes[id] = 0;
+    for(int live_index=0; live_index < all_gameplay_entities->live_count; ++live_index) rehash_entity(all_gameplay_entities->live_ids[live_index]);
+    for(int tile=0; tile < test_tile_map->tile_count; ++tile) tile_hash_sum += state_hash_tile(tile, test_tile_map->bitmap[tile]);
+  }
+
+  match(const match&) = delete;
+  match& operator=(const match&) = delete;
+
+  ~match()
+  {
+    delete[] entity_hashes;
+    delete[] all_move_requests;
+    delete all_entity_moves;
+    delete tile_to_gameplay_entities;
+    delete all_gameplay_entities;
+    delete test_tile_triggers;
+    delete test_tile_map;
+  }
+
+  gameplay_entity_handle spawn_entity(const gameplay_entity_type type, const sf::Vector2f& origin_position, const sf::Vector2f& collision_size)  // invalid handle when full
+  {
+    gameplay_entity_handle handle = all_gameplay_entities->spawn(type, origin_position, collision_size);
+    if (handle.id == -1) return handle;
+
+    all_entity_moves->add_entity(handle.id, origin_position, *test_tile_map);
+    tile_to_gameplay_entities->add_entity(handle.id, *test_tile_map, *all_gameplay_entities);
+    rehash_entity(handle.id);
+    if (recorder) recorder->record_spawn(handle, type, origin_position, collision_size);
+    return handle;
+  }
+
+  bool despawn_entity(const gameplay_entity_handle handle)
+  {
+    if ( !all_gameplay_entities->is_valid(handle) ) return false;
+
+    if (recorder) recorder->record_despawn(handle);
+    all_entity_moves->remove_entity(handle.id, *test_tile_map);
+    tile_to_gameplay_entities->remove_entity(handle.id);
+    entity_hash_sum -= entity_hashes[handle.id];
+    entity_hashes[handle.id] = 0;
+    return all_gameplay_entities->despawn(handle);
+  }
+
+  movement_stats current_movement_stats() const  // the summed counters plus the tile buckets' occupancy right now
+  {
+    movement_stats stats = movement;
+    stats.add_tile_buckets(*tile_to_gameplay_entities);
+    return stats;
+  }
+
+  std::uint64_t state_hash() const { return state_hash_combine(entity_hash_sum, tile_hash_sum); }  // positions, velocities, types and the bitmap, equal hashes on the same tick mean the runs haven't diverged
+
+  std::uint64_t full_state_hash() const  // state_hash() computed from scratch, for checking the incremental one
+  {
+    std::uint64_t entity_sum = 0;
+    std::uint64_t tile_sum   = 0;
+    for(int live_index=0; live_index < all_gameplay_entities->live_count; ++live_index) entity_sum += hash_entity(all_gameplay_entities->live_ids[live_index]);
+    for(int tile=0; tile < test_tile_map->tile_count; ++tile) tile_sum += state_hash_tile(tile, test_tile_map->bitmap[tile]);
+    return state_hash_combine(entity_sum, tile_sum);
+  }
+
+  template<typename p_function>
+  void tick(const float tick_seconds, p_function&& generate_player_move_requests)  // generate_player_move_requests(match&) fills all_move_requests for players, e.g. from their move chambers
+  {
+    PROFILE_TICK_PHASE(timings, tick_phase::TICK);
+
+    {
+      PROFILE_TICK_PHASE(timings, tick_phase::MOVE_GENERATION);
+
+      // reset all live move requests by setting request velocities to (0,0)
+      for(int live_index=0; live_index < all_gameplay_entities->live_count; ++live_index) all_move_requests[all_gameplay_entities->live_ids[live_index]].velocity = sf::Vector2f(0.0f,0.0f);
+
+      generate_player_move_requests(*this);
+
+      if (recorder)
+      {
+        for(int live_index=0; live_index < all_gameplay_entities->live_count; ++live_index)
+        {
+          const int id = all_gameplay_entities->live_ids[live_index];
+          if ( (all_move_requests[id].velocity.x != 0.0f) || (all_move_requests[id].velocity.y != 0.0f) ) recorder->record_move_request(id, all_move_requests[id]);
+        }
+      }
+
+      // generate test movement requests
+      generate_move_request_input stress_test_move_requests[MATCH_STRESS_MOVER_COUNT];
+      const sf::Vector2f directions[] = { sf::Vector2f(1.0f,0.0f), sf::Vector2f(-1.0f,0.0f), sf::Vector2f(0.0f,1.0f), sf::Vector2f(0.0f,-1.0f) };
+      std::uniform_int_distribution<int> direction_distribution(0, 3);
+      for(int i=0; i < MATCH_STRESS_MOVER_COUNT; ++i)
+      {
+        stress_test_move_requests[i].gameplay_entity_id = (i+1);
+        stress_test_move_requests[i].velocity           = directions[direction_distribution(random_generator)] * MATCH_STRESS_MOVER_SPEED;
+      }
+      all_gameplay_entities->generate_move_requests(stress_test_move_requests, all_move_requests, MATCH_STRESS_MOVER_COUNT, test_tile_map->tile_size_x, test_tile_map->tile_size_y);
+    }
+
+    // update movement
+    { PROFILE_TICK_PHASE(timings, tick_phase::SUBMIT_ALL_MOVES);     all_entity_moves->submit_all_moves(all_move_requests, *test_tile_map, *all_gameplay_entities); }
+    { PROFILE_TICK_PHASE(timings, tick_phase::UPDATE_BY_VELOCITIES); all_entity_moves->update_by_velocities(tick_seconds, *test_tile_map, *all_gameplay_entities); }
+    { PROFILE_TICK_PHASE(timings, tick_phase::SET_ALL_POSITIONS);    all_gameplay_entities->set_all_positions(all_entity_moves->current_origin_x, all_entity_moves->current_origin_y); }
+    movement.add_tick(*all_entity_moves);
+
+    // sort gameplay entities by tile
+    {
+      PROFILE_TICK_PHASE(timings, tick_phase::TILE_BUCKETS);
+      tile_to_gameplay_entities->update_moved_entities(*test_tile_map, *all_gameplay_entities, all_entity_moves->moved_ids, all_entity_moves->moved_count);
+      for(int moved_index=0; moved_index < all_entity_moves->moved_count; ++moved_index) rehash_entity(all_entity_moves->moved_ids[moved_index]);  // every velocity change starts or ends a move so only moved entities changed
+    }
+
+    // activate tile_map triggers entered this tick
+    {
+      PROFILE_TICK_PHASE(timings, tick_phase::TRIGGERS);
+      test_tile_triggers->dispatch_events(all_entity_moves->tile_events, all_entity_moves->tile_event_count, [&](const tile_trigger_type type, const gameplay_tile_event& tile_event)
+      {
+        if ( (tile_event.type != gameplay_tile_event_type::ENTER) || (type != tile_trigger_type::TEST) ) return;
+
+        all_gameplay_entities->animation_indexes[tile_event.gameplay_entity_id] = (all_gameplay_entities->animation_indexes[tile_event.gameplay_entity_id] + 1) % 3;
+        set_tile(tile_event.tile_index, 0);
+        test_tile_triggers->remove_trigger(tile_event.tile_index);
+        ++triggered_count;
+      });
+    }
+
+    ++tick_count;
+    #ifdef _DEBUG
+      assert(state_hash() == full_state_hash());
+    #endif
+    if (recorder) recorder->end_tick(static_cast<std::uint32_t>(tick_count), state_hash());
+  }
+
+  private:
+    std::uint64_t hash_entity(const int id) const
+    {
+      state_hasher hasher;
+      hasher.add(static_cast<std::uint32_t>(id));
+      hasher.add(static_cast<std::uint32_t>(all_gameplay_entities->types[id]));
+      hasher.add(all_entity_moves->current_origin_x[id]);
+      hasher.add(all_entity_moves->current_origin_y[id]);
+      hasher.add(all_entity_moves->velocity_x[id]);
+      hasher.add(all_entity_moves->velocity_y[id]);
+      return hasher.value;
+    }
+
+    void rehash_entity(const int id)
+    {
+      const std::uint64_t hash = hash_entity(id);
+      entity_hash_sum += hash - entity_hashes[id];
+      entity_hashes[id] = hash;
+    }
+
+    void set_tile(const int tile, const int value)  // every bitmap write goes through here so tile_hash_sum follows
+    {
+      tile_hash_sum -= state_hash_tile(tile, test_tile_map->bitmap[tile]);
+      test_tile_map->bitmap[tile] = value;
+      tile_hash_sum += state_hash_tile(tile, value);
+    }
+};
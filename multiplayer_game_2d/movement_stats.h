@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdio.h>
+#include "gameplay.h"
+
+
+/*
+   @remember: the movement system counts what it did every tick (gameplay_move_submit_counters, moved_count, arrived_count), movement_stats sums those over ticks and matches
+   @remember: tile bucket occupancy is a scan of every tile so it is only sampled when stats are read (see match::current_movement_stats), not every tick
+   @remember: print() is one JSON object per line on stdout like the histograms (histogram.h), totals plus the tick count so rates per tick are totals / ticks
+*/
+
+
+#define MOVEMENT_STATS_OCCUPANCY_BUCKETS 5   // tiles holding 0 to 3 entity entries, the last bucket counts 4 or more
+
+
+
+/* stats stuff */
+struct movement_stats
+{
+  long long tick_count               = 0;
+  long long requested                = 0;
+  long long ignored_while_moving     = 0;
+  long long cancelled_by_wall        = 0;
+  long long cancelled_by_moving      = 0;
+  long long cancelled_by_destination = 0;
+  long long cancelled_by_length      = 0;
+  long long submitted                = 0;
+  long long chained                  = 0;
+  long long chain_length_counts[GAMEPLAY_CHAIN_LENGTH_BUCKETS] = {};
+  long long moved                    = 0;   // entity ticks spent moving
+  long long arrived                  = 0;
+  int       max_submitted_per_tick   = 0;
+  int       max_moved_per_tick       = 0;
+
+  // sampled from gameplay_entity_ids_per_tile, summed over matches when merged
+  long long tile_counts_by_occupancy[MOVEMENT_STATS_OCCUPANCY_BUCKETS] = {};
+  long long dropped_bucket_entry_count = 0;   // since the buckets were created
+
+  template<int max_entity_count, int tile_map_width, int tile_map_height>
+  void add_tick(const gameplay_entity_moves<max_entity_count,tile_map_width,tile_map_height>& moves)  // after update_by_velocities
+  {
+    const gameplay_move_submit_counters& counters = moves.submit_counters;
+
+    ++tick_count;
+    requested                += counters.requested;
+    ignored_while_moving     += counters.ignored_while_moving;
+    cancelled_by_wall        += counters.cancelled_by_wall;
+    cancelled_by_moving      += counters.cancelled_by_moving;
+    cancelled_by_destination += counters.cancelled_by_destination;
+    cancelled_by_length      += counters.cancelled_by_length;
+    submitted                += counters.submitted;
+    chained                  += counters.chained;
+    for(int i=0; i < GAMEPLAY_CHAIN_LENGTH_BUCKETS; ++i) chain_length_counts[i] += counters.chain_length_counts[i];
+    moved                    += moves.moved_count;
+    arrived                  += moves.arrived_count;
+
+    if (counters.submitted > max_submitted_per_tick) max_submitted_per_tick = counters.submitted;
+    if (moves.moved_count  > max_moved_per_tick)     max_moved_per_tick     = moves.moved_count;
+  }
+
+  template<int p_tile_map_width, int p_tile_map_height, int p_max_gameplay_entities, int p_max_entities_per_tile>
+  void add_tile_buckets(const gameplay_entity_ids_per_tile<p_tile_map_width,p_tile_map_height,p_max_gameplay_entities,p_max_entities_per_tile>& tile_buckets)
+  {
+    tile_buckets.count_bucket_occupancy(tile_counts_by_occupancy, MOVEMENT_STATS_OCCUPANCY_BUCKETS);
+    dropped_bucket_entry_count += tile_buckets.dropped_entry_count;
+  }
+
+  void merge(const movement_stats& other)
+  {
+    tick_count               += other.tick_count;
+    requested                += other.requested;
+    ignored_while_moving     += other.ignored_while_moving;
+    cancelled_by_wall        += other.cancelled_by_wall;
+    cancelled_by_moving      += other.cancelled_by_moving;
+    cancelled_by_destination += other.cancelled_by_destination;
+    cancelled_by_length      += other.cancelled_by_length;
+    submitted                += other.submitted;
+    chained                  += other.chained;
+    for(int i=0; i < GAMEPLAY_CHAIN_LENGTH_BUCKETS; ++i) chain_length_counts[i] += other.chain_length_counts[i];
+    moved                    += other.moved;
+    arrived                  += other.arrived;
+
+    if (other.max_submitted_per_tick > max_submitted_per_tick) max_submitted_per_tick = other.max_submitted_per_tick;
+    if (other.max_moved_per_tick     > max_moved_per_tick)     max_moved_per_tick     = other.max_moved_per_tick;
+
+    for(int i=0; i < MOVEMENT_STATS_OCCUPANCY_BUCKETS; ++i) tile_counts_by_occupancy[i] += other.tile_counts_by_occupancy[i];
+    dropped_bucket_entry_count += other.dropped_bucket_entry_count;
+  }
+
+  void print(const char* const source) const
+  {
+    printf("{\"movement\":\"%s\",\"ticks\":%lld,\"requested\":%lld,\"ignored_while_moving\":%lld,\"cancelled_by_wall\":%lld,\"cancelled_by_moving\":%lld,\"cancelled_by_destination\":%lld,\"cancelled_by_length\":%lld,"
+           "\"submitted\":%lld,\"chained\":%lld,\"moved\":%lld,\"arrived\":%lld,\"max_submitted_per_tick\":%d,\"max_moved_per_tick\":%d,\"chain_lengths\":[",
+           source, tick_count, requested, ignored_while_moving, cancelled_by_wall, cancelled_by_moving, cancelled_by_destination, cancelled_by_length,
+           submitted, chained, moved, arrived, max_submitted_per_tick, max_moved_per_tick);
+    for(int i=0; i < GAMEPLAY_CHAIN_LENGTH_BUCKETS; ++i) printf("%s%lld", i ? "," : "", chain_length_counts[i]);
+
+    printf("],\"tiles_by_occupancy\":[");
+    for(int i=0; i < MOVEMENT_STATS_OCCUPANCY_BUCKETS; ++i) printf("%s%lld", i ? "," : "", tile_counts_by_occupancy[i]);
+    printf("],\"dropped_bucket_entries\":%lld}\n", dropped_bucket_entry_count);
+  }
+};
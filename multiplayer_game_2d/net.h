@@ -0,0 +1,390 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+  // @remember: include before <windows.h> (or define WIN32_LEAN_AND_MEAN) so the old winsock.h doesn't get pulled in first
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+  #pragma comment(lib, "Ws2_32.lib")
+#else
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <arpa/inet.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <errno.h>
+  #include <sys/select.h>
+#endif
+
+#ifdef __linux__
+  #include <sys/epoll.h>
+#endif
+
+
+// @remember: thin non-blocking UDP layer shared by the server and clients, everything above this is in protocol.h
+
+
+#define NET_MAX_PACKET_SIZE 1200   // stay under common MTUs so datagrams aren't fragmented
+#define NET_BATCH_SIZE      64     // datagrams moved per recvmmsg/sendmmsg
+#define NET_POLLER_CAPACITY 16     // sockets one net_poller can wait on
+
+
+
+/* address stuff */
+struct net_address
+{
+  std::uint32_t ip   = 0;   // host byte order
+  std::uint16_t port = 0;   // host byte order
+
+  bool operator==(const net_address& other) const { return (ip == other.ip) && (port == other.port); }
+  bool operator!=(const net_address& other) const { return !(*this == other); }
+
+  bool parse(const char* const ip_string, const std::uint16_t p_port)  // dotted ipv4 only
+  {
+    in_addr address;
+    if (inet_pton(AF_INET, ip_string, &address) != 1) return false;
+
+    ip   = ntohl(address.s_addr);
+    port = p_port;
+    return true;
+  }
+
+  void to_string(char* const buffer, const int buffer_size) const
+  {
+    snprintf(buffer, buffer_size, "%u.%u.%u.%u:%u", (ip >> 24) & 0xFF, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF, port);
+  }
+};
+
+
+
+/* socket stuff */
+inline bool net_startup()  // call once before opening sockets
+{
+  #ifdef _WIN32
+    WSADATA wsa_data;
+    return WSAStartup(MAKEWORD(2,2), &wsa_data) == 0;
+  #else
+    return true;
+  #endif
+}
+
+inline void net_shutdown()
+{
+  #ifdef _WIN32
+    WSACleanup();
+  #endif
+}
+
+struct udp_socket
+{
+  #ifdef _WIN32
+    SOCKET handle = INVALID_SOCKET;
+  #else
+    int handle = -1;
+  #endif
+
+  udp_socket() = default;
+  udp_socket(const udp_socket&) = delete;
+  udp_socket& operator=(const udp_socket&) = delete;
+  ~udp_socket() { close(); }
+
+  bool is_open() const
+  {
+    #ifdef _WIN32
+      return handle != INVALID_SOCKET;
+    #else
+      return handle != -1;
+    #endif
+  }
+
+  bool open(const std::uint16_t port)  // 0 picks an ephemeral port, the socket is non-blocking
+  {
+    close();
+
+    handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (!is_open()) return false;
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port        = htons(port);
+
+    if (bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+      close();
+      return false;
+    }
+
+    #ifdef _WIN32
+      u_long is_non_blocking = 1;
+      if (ioctlsocket(handle, FIONBIO, &is_non_blocking) != 0) { close(); return false; }
+    #else
+      if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == -1) { close(); return false; }
+    #endif
+
+    return true;
+  }
+
+  void close()
+  {
+    if (!is_open()) return;
+
+    #ifdef _WIN32
+      closesocket(handle);
+      handle = INVALID_SOCKET;
+    #else
+      ::close(handle);
+      handle = -1;
+    #endif
+  }
+
+  std::uint16_t local_port() const
+  {
+    sockaddr_in address;
+    socklen_t address_size = sizeof(address);
+    if (getsockname(handle, reinterpret_cast<sockaddr*>(&address), &address_size) != 0) return 0;
+    return ntohs(address.sin_port);
+  }
+
+  bool send(const net_address& destination, const void* const data, const int size) const
+  {
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(destination.ip);
+    address.sin_port        = htons(destination.port);
+
+    return sendto(handle, static_cast<const char*>(data), size, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == size;
+  }
+
+  int receive(net_address& source, void* const buffer, const int buffer_size) const  // returns the datagram size, 0 when nothing is queued
+  {
+    sockaddr_in address;
+    socklen_t address_size = sizeof(address);
+
+    int size = static_cast<int>( recvfrom(handle, static_cast<char*>(buffer), buffer_size, 0, reinterpret_cast<sockaddr*>(&address), &address_size) );
+    if (size <= 0) return 0;  // would block, or an icmp error from an earlier send (ignored, peers time out instead)
+
+    source.ip   = ntohl(address.sin_addr.s_addr);
+    source.port = ntohs(address.sin_port);
+    return size;
+  }
+};
+
+
+
+/* batch stuff */
+// @remember: on linux a batch is one recvmmsg/sendmmsg, elsewhere it falls back to one recvfrom/sendto per datagram (the counters show the difference)
+// @remember: received datagrams stay in the batch buffers, parse them in place before the next receive_batch
+struct net_packet_batch  // big, allocate on the heap
+{
+  int           count = 0;
+  net_address   addresses[NET_BATCH_SIZE];
+  int           sizes[NET_BATCH_SIZE];
+  std::uint8_t  buffers[NET_BATCH_SIZE][NET_MAX_PACKET_SIZE];
+
+  long long syscall_count = 0;   // recvmmsg/sendmmsg (or recvfrom/sendto) calls that moved datagrams or drained the socket
+  long long packet_count  = 0;
+  long long byte_count    = 0;
+
+  bool is_full() const { return count == NET_BATCH_SIZE; }
+
+  std::uint8_t* next_buffer() { return buffers[count]; }  // write the next outgoing datagram here then push it, check is_full first
+
+  void push(const net_address& destination, const int size)
+  {
+    addresses[count] = destination;
+    sizes[count]     = size;
+    ++count;
+  }
+
+  float packets_per_syscall() const { return (syscall_count > 0) ? static_cast<float>(packet_count) / syscall_count : 0.0f; }
+};
+
+inline int receive_batch(const udp_socket& socket, net_packet_batch& batch)  // replaces the batch contents, returns the datagram count, less than NET_BATCH_SIZE means the socket is drained
+{
+  batch.count = 0;
+
+  #ifdef __linux__
+    mmsghdr     messages[NET_BATCH_SIZE];
+    iovec       vectors[NET_BATCH_SIZE];
+    sockaddr_in addresses[NET_BATCH_SIZE];
+    memset(messages, 0, sizeof(messages));
+
+    for(int i=0; i < NET_BATCH_SIZE; ++i)
+    {
+      vectors[i].iov_base                = batch.buffers[i];
+      vectors[i].iov_len                 = NET_MAX_PACKET_SIZE;
+      messages[i].msg_hdr.msg_iov        = &vectors[i];
+      messages[i].msg_hdr.msg_iovlen     = 1;
+      messages[i].msg_hdr.msg_name       = &addresses[i];
+      messages[i].msg_hdr.msg_namelen    = sizeof(addresses[i]);
+    }
+
+    int received_count = recvmmsg(socket.handle, messages, NET_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+    ++batch.syscall_count;
+    if (received_count <= 0) return 0;  // would block, or an icmp error from an earlier send
+
+    for(int i=0; i < received_count; ++i)
+    {
+      if (messages[i].msg_len == 0) continue;
+
+      batch.addresses[batch.count].ip   = ntohl(addresses[i].sin_addr.s_addr);
+      batch.addresses[batch.count].port = ntohs(addresses[i].sin_port);
+      batch.sizes[batch.count]          = static_cast<int>(messages[i].msg_len);
+      if (batch.count != i) memmove(batch.buffers[batch.count], batch.buffers[i], messages[i].msg_len);
+      ++batch.count;
+    }
+  #else
+    while (batch.count < NET_BATCH_SIZE)
+    {
+      int size = socket.receive(batch.addresses[batch.count], batch.buffers[batch.count], NET_MAX_PACKET_SIZE);
+      ++batch.syscall_count;
+      if (size == 0) break;
+
+      batch.sizes[batch.count] = size;
+      ++batch.count;
+    }
+  #endif
+
+  batch.packet_count += batch.count;
+  for(int i=0; i < batch.count; ++i) batch.byte_count += batch.sizes[i];
+  return batch.count;
+}
+
+inline int send_batch(const udp_socket& socket, net_packet_batch& batch)  // sends and empties the batch, returns the datagrams the kernel took
+{
+  if (batch.count == 0) return 0;
+  int sent_count = 0;
+
+  #ifdef __linux__
+    mmsghdr     messages[NET_BATCH_SIZE];
+    iovec       vectors[NET_BATCH_SIZE];
+    sockaddr_in addresses[NET_BATCH_SIZE];
+    memset(messages,  0, sizeof(messages));
+    memset(addresses, 0, sizeof(addresses));
+
+    for(int i=0; i < batch.count; ++i)
+    {
+      addresses[i].sin_family            = AF_INET;
+      addresses[i].sin_addr.s_addr       = htonl(batch.addresses[i].ip);
+      addresses[i].sin_port              = htons(batch.addresses[i].port);
+      vectors[i].iov_base                = batch.buffers[i];
+      vectors[i].iov_len                 = static_cast<size_t>(batch.sizes[i]);
+      messages[i].msg_hdr.msg_iov        = &vectors[i];
+      messages[i].msg_hdr.msg_iovlen     = 1;
+      messages[i].msg_hdr.msg_name       = &addresses[i];
+      messages[i].msg_hdr.msg_namelen    = sizeof(addresses[i]);
+    }
+
+    while (sent_count < batch.count)
+    {
+      int result = sendmmsg(socket.handle, messages + sent_count, static_cast<unsigned int>(batch.count - sent_count), 0);
+      ++batch.syscall_count;
+      if (result <= 0) break;  // a full send buffer drops the rest like a lost datagram would
+
+      for(int i=sent_count; i < sent_count + result; ++i) batch.byte_count += batch.sizes[i];
+      sent_count += result;
+    }
+  #else
+    for(int i=0; i < batch.count; ++i)
+    {
+      ++batch.syscall_count;
+      if ( !socket.send(batch.addresses[i], batch.buffers[i], batch.sizes[i]) ) continue;
+
+      batch.byte_count += batch.sizes[i];
+      ++sent_count;
+    }
+  #endif
+
+  batch.packet_count += sent_count;
+  batch.count = 0;
+  return sent_count;
+}
+
+
+
+/* poller stuff */
+// @remember: lets a loop sleep until a datagram arrives or its next deadline, whichever is first, instead of sleeping the whole way and reading late
+struct net_poller
+{
+  long long wait_count  = 0;
+  long long ready_count = 0;   // waits that ended because a socket was readable
+
+  private:
+    #ifdef __linux__
+      int epoll_handle = -1;
+    #endif
+    const udp_socket* sockets[NET_POLLER_CAPACITY];
+    int               socket_count = 0;
+  public:
+
+  net_poller()
+  {
+    #ifdef __linux__
+      epoll_handle = epoll_create1(0);
+    #endif
+  }
+
+  net_poller(const net_poller&) = delete;
+  net_poller& operator=(const net_poller&) = delete;
+
+  ~net_poller()
+  {
+    #ifdef __linux__
+      if (epoll_handle != -1) ::close(epoll_handle);
+    #endif
+  }
+
+  bool add(const udp_socket& socket)
+  {
+    if ( !socket.is_open() || (socket_count == NET_POLLER_CAPACITY) ) return false;
+
+    #ifdef __linux__
+      if (epoll_handle == -1) return false;
+
+      epoll_event event;
+      memset(&event, 0, sizeof(event));
+      event.events   = EPOLLIN;
+      event.data.u32 = static_cast<std::uint32_t>(socket_count);
+      if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, socket.handle, &event) != 0) return false;
+    #endif
+
+    sockets[socket_count] = &socket;
+    ++socket_count;
+    return true;
+  }
+
+  int wait(const float timeout_seconds)  // returns how many sockets are readable, 0 on timeout
+  {
+    const int timeout_microseconds = (timeout_seconds > 0.0f) ? static_cast<int>(timeout_seconds * 1000000.0f) : 0;
+    ++wait_count;
+
+    #ifdef __linux__
+      epoll_event events[NET_POLLER_CAPACITY];
+      int result = epoll_wait(epoll_handle, events, NET_POLLER_CAPACITY, (timeout_microseconds + 999) / 1000);  // round up so a wait never ends before the deadline
+    #else
+      fd_set readable;
+      FD_ZERO(&readable);
+      int max_handle = 0;
+      for(int i=0; i < socket_count; ++i)
+      {
+        FD_SET(sockets[i]->handle, &readable);
+        if (static_cast<int>(sockets[i]->handle) > max_handle) max_handle = static_cast<int>(sockets[i]->handle);
+      }
+
+      timeval timeout;
+      timeout.tv_sec  = timeout_microseconds / 1000000;
+      timeout.tv_usec = timeout_microseconds % 1000000;
+      int result = select(max_handle + 1, &readable, nullptr, nullptr, &timeout);  // the first argument is ignored on windows
+    #endif
+
+    if (result <= 0) return 0;
+    ++ready_count;
+    return result;
+  }
+};
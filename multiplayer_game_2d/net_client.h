@@ -0,0 +1,626 @@
+#pragma once
+
+#include <cmath>
+#include "net.h"
+#include "protocol.h"
+#include "gameplay.h"
+#include "arena.h"
+#include "snapshot.h"
+
+
+// @remember: shared by the SFML client (main.cpp) and the headless test client, no SFML graphics here
+
+
+
+/* connection stuff */
+enum class net_client_state : int
+{
+  DISCONNECTED = 0,
+  CONNECTING   = 1,
+  CONNECTED    = 2,
+  DENIED       = 3   // server was full
+};
+
+struct net_client
+{
+  udp_socket             socket;
+  net_address            server_address;
+  net_client_state       state = net_client_state::DISCONNECTED;
+  connect_accept_message accept;                           // valid once CONNECTED
+
+  world_snapshot latest_state;                             // newest STATE decoded, allocated once CONNECTED
+  std::uint32_t  latest_acked_input_sequence = 0;          // newest input the server had applied as of latest_state
+  player_input_direction latest_acked_chamber_direction = player_input_direction::NONE;  // the server's move chamber for this client as of latest_state
+  bool           has_new_state               = false;      // set when latest_state changes, the caller clears it
+  long long      received_state_count        = 0;
+  long long      undecodable_state_count     = 0;          // deltas against a baseline this client no longer has
+  long long      desync_count                = 0;          // STATEs that decoded to a different hash than the server's, they are dropped
+  std::uint32_t  first_desync_tick           = 0;          // reported to the server in every INPUT, 0 for none
+  long long      received_byte_count         = 0;
+  long long      sent_byte_count             = 0;
+
+  private:
+    input_message                  recent_inputs;          // newest first, resent every INPUT for redundancy
+    std::uint32_t                  next_input_sequence          = 1;
+    float                          seconds_since_connect_request = 0.0f;
+    float                          seconds_since_receive         = 0.0f;
+    snapshot_layout                layout;
+    world_snapshot                 initial_snapshot;       // baseline tick 0
+    std::unique_ptr<snapshot_ring> received_snapshots;     // baselines the server may send deltas against
+  public:
+
+  bool start(const char* const server_ip, const std::uint16_t server_port)
+  {
+    if ( !server_address.parse(server_ip, server_port) ) return false;
+    if ( !socket.open(0) ) return false;
+
+    state = net_client_state::CONNECTING;
+    seconds_since_connect_request = CONNECT_RETRY_SECONDS;  // send the first request on the next update
+    seconds_since_receive         = 0.0f;
+    return true;
+  }
+
+  void update(const float elapsed_seconds)  // call every frame, handles (re)connecting, timeouts and receiving
+  {
+    if ( (state == net_client_state::DISCONNECTED) || (state == net_client_state::DENIED) ) return;
+
+    seconds_since_receive += elapsed_seconds;
+    if (seconds_since_receive > CONNECTION_TIMEOUT_SECONDS)
+    {
+      state = net_client_state::DISCONNECTED;
+      return;
+    }
+
+    if (state == net_client_state::CONNECTING)
+    {
+      seconds_since_connect_request += elapsed_seconds;
+      if (seconds_since_connect_request >= CONNECT_RETRY_SECONDS)
+      {
+        seconds_since_connect_request = 0.0f;
+        send_packet_with_header_only(packet_type::CONNECT_REQUEST);
+      }
+    }
+
+    std::uint8_t buffer[NET_MAX_PACKET_SIZE];
+    net_address  source;
+    int          size;
+
+    while ( (size = socket.receive(source, buffer, sizeof(buffer))) > 0 )
+    {
+      if (source != server_address) continue;
+
+      byte_reader reader(buffer, size);
+      packet_type type;
+      if ( !read_packet_header(reader, type) ) continue;
+
+      received_byte_count  += size;
+      seconds_since_receive = 0.0f;
+
+      switch (type)
+      {
+        case packet_type::CONNECT_ACCEPT:
+             if ( (state == net_client_state::CONNECTING) && accept.read(reader) && (accept.map_width >= TEST_ARENA_MIN_WIDTH) && (accept.map_height >= TEST_ARENA_MIN_HEIGHT) )
+             {
+               create_snapshots();
+               state = net_client_state::CONNECTED;
+             }
+             break;
+
+        case packet_type::CONNECT_DENIED:
+             if (state == net_client_state::CONNECTING) state = net_client_state::DENIED;
+             break;
+
+        case packet_type::DISCONNECT:
+             state = net_client_state::DISCONNECTED;
+             break;
+
+        case packet_type::STATE:
+        {
+          if (state != net_client_state::CONNECTED) break;
+
+          state_message received_state;
+          if ( !received_state.read_header(reader) ) break;
+          if ( (received_state.tick == 0) || ((received_state_count > 0) && !sequence_greater_than(received_state.tick, latest_state.tick)) ) break;  // old or duplicate
+
+          const world_snapshot* baseline = (received_state.baseline_tick == 0) ? &initial_snapshot : received_snapshots->find(received_state.baseline_tick, received_state.tick);
+          if (!baseline)
+          {
+            ++undecodable_state_count;  // the server falls back to the initial baseline once it stops getting acks
+            break;
+          }
+
+          world_snapshot& snapshot = received_snapshots->slot(received_state.tick);
+          if ( !received_state.read_snapshot(reader, *baseline, snapshot, layout) ) break;
+
+          if ( static_cast<std::uint32_t>(snapshot.hash()) != received_state.state_hash )
+          {
+            // never acked so the server keeps sending deltas against older baselines, falling back to a full state once they age out
+            snapshot.is_valid = false;
+            ++desync_count;
+            if (first_desync_tick == 0)
+            {
+              first_desync_tick = received_state.tick;
+
+              char path[64];
+              snprintf(path, sizeof(path), "desync_%u_entity_%d_client.txt", received_state.tick, accept.entity_id);
+              write_snapshot_dump(path, snapshot, layout, accept.map_width);
+            }
+            break;
+          }
+
+          latest_state.copy_from(snapshot, layout);
+          latest_acked_input_sequence    = received_state.acked_input_sequence;
+          latest_acked_chamber_direction = received_state.acked_chamber_direction;
+          has_new_state = true;
+          ++received_state_count;
+          break;
+        }
+
+        default:
+             break;
+      }
+    }
+  }
+
+  std::uint32_t send_input(const player_input_direction direction)  // call every client tick once CONNECTED, returns the input's sequence
+  {
+    if (state != net_client_state::CONNECTED) return 0;
+
+    // shift the older inputs back and put the newest first
+    int kept_count = (recent_inputs.direction_count < INPUT_REDUNDANCY) ? recent_inputs.direction_count : (INPUT_REDUNDANCY - 1);
+    for(int i=kept_count; i > 0; --i) recent_inputs.directions[i] = recent_inputs.directions[i - 1];
+
+    recent_inputs.directions[0]    = direction;
+    recent_inputs.direction_count  = kept_count + 1;
+    recent_inputs.newest_sequence  = next_input_sequence;
+    recent_inputs.acked_state_tick = (received_state_count > 0) ? latest_state.tick : 0;
+    recent_inputs.desync_tick      = first_desync_tick;
+    ++next_input_sequence;
+
+    std::uint8_t buffer[NET_MAX_PACKET_SIZE];
+    byte_writer writer(buffer, sizeof(buffer));
+    write_packet_header(writer, packet_type::INPUT);
+    recent_inputs.write(writer);
+
+    socket.send(server_address, buffer, writer.size);
+    sent_byte_count += writer.size;
+
+    return recent_inputs.newest_sequence;
+  }
+
+  void disconnect()
+  {
+    if (state == net_client_state::CONNECTED) send_packet_with_header_only(packet_type::DISCONNECT);
+    state = net_client_state::DISCONNECTED;
+    socket.close();
+  }
+
+  private:
+    void create_snapshots()
+    {
+      layout = accept.layout();
+
+      // the initial baseline is the test arena both sides generate, without entities
+      tile_map<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE> initial_tile_map(accept.map_width, accept.map_height, accept.tile_size_x * accept.map_width, accept.tile_size_y * accept.map_height);
+      generate_test_arena_bitmap(initial_tile_map);
+
+      initial_snapshot.allocate(layout);
+      initial_snapshot.capture_bitmap(initial_tile_map);
+      initial_snapshot.is_valid = true;
+
+      latest_state.allocate(layout);
+      received_snapshots.reset(new snapshot_ring(layout));
+    }
+
+    void send_packet_with_header_only(const packet_type type)
+    {
+      std::uint8_t buffer[PACKET_HEADER_SIZE];
+      byte_writer writer(buffer, sizeof(buffer));
+      write_packet_header(writer, type);
+
+      socket.send(server_address, buffer, writer.size);
+      sent_byte_count += writer.size;
+    }
+};
+
+
+
+/* replication stuff */
+template<int p_max_size>
+struct replicated_entities
+{
+  /*
+     @remember: mirrors the server's entities into a local gameplay_entities using the server's ids (spawn_with_id) so sprites and debug text line up with server ids
+     @remember: positions arrive in tiles (see snapshot.h) so the client's tile_map must have the server's width and height but can use any tile size
+     @remember: the tile_map bitmap is mirrored too
+  */
+
+  float origin_x[p_max_size];
+  float origin_y[p_max_size];
+
+  replicated_entities()
+  {
+    for(int id=0; id < p_max_size; ++id)
+    {
+      origin_x[id] = 0.0f;
+      origin_y[id] = 0.0f;
+    }
+  }
+
+  template<int p_width, int p_height>
+  void apply(const world_snapshot& snapshot, tile_map<p_width,p_height>& p_tile_map, gameplay_entities<p_max_size>& p_gameplay_entities)
+  {
+    const sf::Vector2f collision_size(p_tile_map.tile_size_x - 2.0f, p_tile_map.tile_size_y - 2.0f);
+
+    for(int present_index=0; present_index < snapshot.present_count; ++present_index)
+    {
+      const int id = snapshot.present_ids[present_index];
+      const snapshot_entity& entity = snapshot.entities[id];
+      if ( (id >= p_max_size) || (entity.tile_index >= p_tile_map.tile_count) ) continue;
+
+      sf::Vector2f origin_position = dequantize_origin_position(entity, p_tile_map);
+
+      // respawn if the slot is new or was reused for another type
+      if ( !p_gameplay_entities.is_garbage_flags[id] && (p_gameplay_entities.types[id] != entity.type) ) p_gameplay_entities.despawn(p_gameplay_entities.handle_of(id));
+      if ( p_gameplay_entities.is_garbage_flags[id] ) p_gameplay_entities.spawn_with_id(id, entity.type, origin_position, collision_size);
+
+      p_gameplay_entities.animation_indexes[id] = entity.animation_index;
+      origin_x[id] = origin_position.x;
+      origin_y[id] = origin_position.y;
+    }
+
+    // despawn entities the server no longer has or this client can no longer see (iterate backwards because despawn swap-removes from live_ids)
+    for(int live_index=p_gameplay_entities.live_count - 1; live_index >= 0; --live_index)
+    {
+      int id = p_gameplay_entities.live_ids[live_index];
+      if ( !snapshot.entities[id].is_present() || (snapshot.entities[id].tile_index >= p_tile_map.tile_count) ) p_gameplay_entities.despawn(p_gameplay_entities.handle_of(id));
+    }
+
+    p_gameplay_entities.set_all_positions(origin_x, origin_y);
+
+    for(int tile=0; tile < p_tile_map.tile_count; ++tile) p_tile_map.bitmap[tile] = snapshot.bitmap[tile];
+  }
+};
+
+
+
+/* interpolation stuff */
+#define INTERPOLATION_BUFFER_SIZE          16      // positions kept per entity, must be a power of two
+#define INTERPOLATION_MIN_DELAY_SECONDS    0.05f   // default floor of the render delay
+#define INTERPOLATION_MAX_DELAY_SECONDS    0.5f
+#define INTERPOLATION_JITTER_MULTIPLIER    3.0f    // delay = snapshot interval + this * measured jitter, covers nearly every late STATE
+#define INTERPOLATION_DELAY_SHRINK_RATE    0.5f    // fraction of the excess delay removed per second once jitter drops, growing is immediate
+#define INTERPOLATION_FILTER_GAIN          (1.0f / 16.0f)  // jitter, clock offset and interval are smoothed like rfc 3550 interarrival jitter
+
+template<int p_max_size>
+struct snapshot_interpolation
+{
+  /*
+     @remember: remote entities are drawn delay_seconds in the past, between the two buffered STATE positions around that time, so they move smoothly even when STATE arrives late or the server sends less often
+     @remember: positions are timestamped with server time (tick * tick_seconds) and mapped to local time through a smoothed clock offset so arrival jitter doesn't move them
+     @remember: the local player isn't drawn from here, see player_prediction
+  */
+
+  float     min_delay_seconds;                        // configurable floor, the delay never adapts below this
+  float     delay_seconds;
+  float     jitter_seconds            = 0.0f;         // smoothed variation of STATE transit time
+  float     snapshot_interval_seconds = 0.0f;         // smoothed server time between received STATEs
+  long long starved_count             = 0;            // frames that rendered past the newest STATE (the delay was too short)
+
+  float origin_x[p_max_size];
+  float origin_y[p_max_size];
+
+  private:
+    double  local_time           = 0.0;
+    double  clock_offset         = 0.0;               // local time - server time, smoothed
+    double  previous_transit     = 0.0;
+    double  previous_server_time = 0.0;
+    bool    has_clock            = false;
+    double* sample_times;                             // INTERPOLATION_BUFFER_SIZE per entity, oldest to newest in ring order
+    float*  sample_x;
+    float*  sample_y;
+    int*    sample_counts;
+    int*    newest_indexes;
+  public:
+
+  snapshot_interpolation(const float p_min_delay_seconds = INTERPOLATION_MIN_DELAY_SECONDS) : min_delay_seconds(p_min_delay_seconds), delay_seconds(p_min_delay_seconds)
+  {
+    sample_times   = new double[p_max_size * INTERPOLATION_BUFFER_SIZE];
+    sample_x       = new float[p_max_size * INTERPOLATION_BUFFER_SIZE];
+    sample_y       = new float[p_max_size * INTERPOLATION_BUFFER_SIZE];
+    sample_counts  = new int[p_max_size];
+    newest_indexes = new int[p_max_size];
+
+    for(int id=0; id < p_max_size; ++id)
+    {
+      origin_x[id]       = 0.0f;
+      origin_y[id]       = 0.0f;
+      sample_counts[id]  = 0;
+      newest_indexes[id] = 0;
+    }
+  }
+
+  snapshot_interpolation(const snapshot_interpolation&) = delete;
+  snapshot_interpolation& operator=(const snapshot_interpolation&) = delete;
+
+  ~snapshot_interpolation()
+  {
+    delete[] newest_indexes;
+    delete[] sample_counts;
+    delete[] sample_y;
+    delete[] sample_x;
+    delete[] sample_times;
+  }
+
+  void advance(const float elapsed_seconds)  // call every frame
+  {
+    local_time += elapsed_seconds;
+
+    float target_delay_seconds = snapshot_interval_seconds + (INTERPOLATION_JITTER_MULTIPLIER * jitter_seconds);
+    if (target_delay_seconds < min_delay_seconds)              target_delay_seconds = min_delay_seconds;
+    if (target_delay_seconds > INTERPOLATION_MAX_DELAY_SECONDS) target_delay_seconds = INTERPOLATION_MAX_DELAY_SECONDS;
+
+    // grow at once so entities don't stall, shrink slowly so render time doesn't visibly speed up
+    if (target_delay_seconds >= delay_seconds) delay_seconds = target_delay_seconds;
+    else
+    {
+      float shrink = INTERPOLATION_DELAY_SHRINK_RATE * elapsed_seconds;
+      delay_seconds -= (delay_seconds - target_delay_seconds) * ((shrink < 1.0f) ? shrink : 1.0f);
+    }
+  }
+
+  template<int p_width, int p_height>
+  void push(const world_snapshot& snapshot, const float tick_seconds, const tile_map<p_width,p_height>& p_tile_map)  // call with every new STATE
+  {
+    const double server_time = static_cast<double>(snapshot.tick) * tick_seconds;
+    const double transit     = local_time - server_time;
+
+    if (!has_clock)
+    {
+      clock_offset = transit;
+      has_clock    = true;
+    }
+    else
+    {
+      double transit_change = transit - previous_transit;
+      jitter_seconds += ( static_cast<float>((transit_change < 0.0) ? -transit_change : transit_change) - jitter_seconds ) * INTERPOLATION_FILTER_GAIN;
+      clock_offset   += (transit - clock_offset) * INTERPOLATION_FILTER_GAIN;
+
+      if (server_time > previous_server_time)
+      {
+        float interval = static_cast<float>(server_time - previous_server_time);
+        snapshot_interval_seconds = (snapshot_interval_seconds == 0.0f) ? interval : snapshot_interval_seconds + ((interval - snapshot_interval_seconds) * INTERPOLATION_FILTER_GAIN);
+      }
+    }
+
+    const double pushed_server_time = previous_server_time;
+    previous_transit     = transit;
+    previous_server_time = server_time;
+
+    for(int present_index=0; present_index < snapshot.present_count; ++present_index)
+    {
+      const int id = snapshot.present_ids[present_index];
+      const snapshot_entity& entity = snapshot.entities[id];
+      if ( (id >= p_max_size) || (entity.tile_index >= p_tile_map.tile_count) ) continue;
+
+      // an entity that wasn't in the previous STATE left (or left view) and came back, or its id was reused, so it starts a new history
+      if ( (sample_counts[id] > 0) && (sample_times[(id * INTERPOLATION_BUFFER_SIZE) + newest_indexes[id]] != pushed_server_time) ) sample_counts[id] = 0;
+
+      // a STATE older than the newest buffered one is dropped by net_client already, so samples stay in time order
+      int index = (newest_indexes[id] + 1) & (INTERPOLATION_BUFFER_SIZE - 1);
+      sf::Vector2f origin_position = dequantize_origin_position(entity, p_tile_map);
+
+      sample_times[(id * INTERPOLATION_BUFFER_SIZE) + index] = server_time;
+      sample_x[(id * INTERPOLATION_BUFFER_SIZE) + index]     = origin_position.x;
+      sample_y[(id * INTERPOLATION_BUFFER_SIZE) + index]     = origin_position.y;
+      newest_indexes[id] = index;
+      if (sample_counts[id] < INTERPOLATION_BUFFER_SIZE) ++sample_counts[id];
+    }
+  }
+
+  double render_server_time() const { return local_time - clock_offset - delay_seconds; }
+
+  void sample(gameplay_entities<p_max_size>& p_gameplay_entities)  // call every frame before drawing, positions the live entities at render_server_time
+  {
+    const double render_time = render_server_time();
+    if ( has_clock && (render_time > previous_server_time) ) ++starved_count;
+
+    for(int live_index=0; live_index < p_gameplay_entities.live_count; ++live_index)
+    {
+      int id = p_gameplay_entities.live_ids[live_index];
+      if (sample_counts[id] == 0) continue;
+
+      const int base = id * INTERPOLATION_BUFFER_SIZE;
+
+      // walk back from the newest to the first position at or before render_time
+      int newer_index = newest_indexes[id];
+      if (render_time >= sample_times[base + newer_index])  // hold the newest position rather than extrapolate
+      {
+        origin_x[id] = sample_x[base + newer_index];
+        origin_y[id] = sample_y[base + newer_index];
+        continue;
+      }
+
+      int older_index = newer_index;
+      for(int i=1; i < sample_counts[id]; ++i)
+      {
+        older_index = (newer_index - 1) & (INTERPOLATION_BUFFER_SIZE - 1);
+        if (sample_times[base + older_index] <= render_time) break;
+        newer_index = older_index;
+      }
+
+      if ( (older_index == newer_index) || (sample_times[base + older_index] > render_time) )  // render_time is before the oldest position
+      {
+        origin_x[id] = sample_x[base + newer_index];
+        origin_y[id] = sample_y[base + newer_index];
+        continue;
+      }
+
+      float alpha = static_cast<float>( (render_time - sample_times[base + older_index]) / (sample_times[base + newer_index] - sample_times[base + older_index]) );
+      origin_x[id] = sample_x[base + older_index] + ((sample_x[base + newer_index] - sample_x[base + older_index]) * alpha);
+      origin_y[id] = sample_y[base + older_index] + ((sample_y[base + newer_index] - sample_y[base + older_index]) * alpha);
+    }
+
+    p_gameplay_entities.set_all_positions(origin_x, origin_y);
+  }
+};
+
+
+
+/* prediction stuff */
+#define PREDICTION_MAX_PENDING_INPUTS  64   // inputs kept for replay, must be a power of two
+#define PREDICTION_CORRECTION_EPSILON  1.0f   // world units, reconciles that move the player less than this are rounding and aren't counted
+
+template<int p_max_size, int p_width, int p_height>
+struct player_prediction
+{
+  /*
+     @remember: the client runs its own player through the same player_move_chamber and gameplay_entity_moves as the server, one tick per input
+     @remember: every STATE rewinds the predicted world to the server's and replays the inputs the server hasn't applied yet
+     @remember: other entities are placed stationary on the tile they are on or moving to so they block (and can be pushed by) the predicted player, they aren't predicted themselves
+  */
+
+  int                 player_id = -1;
+  player_move_chamber chamber;
+  long long           correction_count         = 0;     // reconciles that moved the predicted player
+  float               last_correction_distance = 0.0f;    // of the newest counted correction
+
+  gameplay_entities<p_max_size>*                 predicted_entities;
+  gameplay_entity_moves<p_max_size,p_width,p_height>* predicted_moves;
+  gameplay_entity_move_request*                  move_requests;
+
+  private:
+    std::uint32_t          pending_sequences[PREDICTION_MAX_PENDING_INPUTS] = {};
+    player_input_direction pending_directions[PREDICTION_MAX_PENDING_INPUTS];
+    std::uint32_t          newest_sequence = 0;
+  public:
+
+  player_prediction(const tile_map<p_width,p_height>& p_tile_map)
+  {
+    predicted_entities = new gameplay_entities<p_max_size>();
+    predicted_moves    = new gameplay_entity_moves<p_max_size,p_width,p_height>(predicted_entities->all_collision_vertices_origin_positions(), predicted_entities->is_garbage_flags, p_tile_map);
+    move_requests      = new gameplay_entity_move_request[p_max_size];
+  }
+
+  player_prediction(const player_prediction&) = delete;
+  player_prediction& operator=(const player_prediction&) = delete;
+
+  ~player_prediction()
+  {
+    delete[] move_requests;
+    delete predicted_moves;
+    delete predicted_entities;
+  }
+
+  bool has_player() const { return (player_id >= 0) && (player_id < p_max_size) && !predicted_entities->is_garbage_flags[player_id]; }
+
+  sf::Vector2f player_origin_position() const { return predicted_moves->current_origin_position(player_id); }
+
+  void step(const std::uint32_t sequence, const player_input_direction direction, const tile_map<p_width,p_height>& p_tile_map, const float tick_seconds)  // call every client tick with the input that was just sent
+  {
+    pending_sequences[sequence & (PREDICTION_MAX_PENDING_INPUTS - 1)]  = sequence;
+    pending_directions[sequence & (PREDICTION_MAX_PENDING_INPUTS - 1)] = direction;
+    newest_sequence = sequence;
+
+    if (has_player()) simulate(direction, p_tile_map, tick_seconds);
+  }
+
+  void reconcile(const world_snapshot& snapshot, const std::uint32_t acked_sequence, const player_input_direction acked_chamber_direction, const tile_map<p_width,p_height>& p_tile_map, const float tick_seconds)  // call with every new STATE
+  {
+    const bool   had_player         = has_player();
+    sf::Vector2f predicted_position = had_player ? player_origin_position() : sf::Vector2f();
+
+    rewind(snapshot, p_tile_map, tick_seconds);
+    if (!has_player()) return;
+
+    chamber.direction = acked_chamber_direction;
+
+    // replay what the server hasn't applied yet, inputs that fell out of the ring are lost
+    std::uint32_t first_sequence = acked_sequence + 1;
+    if ( (newest_sequence - acked_sequence) > PREDICTION_MAX_PENDING_INPUTS ) first_sequence = newest_sequence - PREDICTION_MAX_PENDING_INPUTS + 1;
+
+    for(std::uint32_t sequence=first_sequence; !sequence_greater_than(sequence, newest_sequence); ++sequence)
+    {
+      int index = sequence & (PREDICTION_MAX_PENDING_INPUTS - 1);
+      simulate( (pending_sequences[index] == sequence) ? pending_directions[index] : player_input_direction::NONE, p_tile_map, tick_seconds );
+    }
+
+    if (had_player)
+    {
+      sf::Vector2f difference = player_origin_position() - predicted_position;
+      float correction_distance = std::sqrt( (difference.x * difference.x) + (difference.y * difference.y) );
+      if (correction_distance > PREDICTION_CORRECTION_EPSILON)
+      {
+        ++correction_count;
+        last_correction_distance = correction_distance;
+      }
+    }
+  }
+
+  private:
+    void simulate(const player_input_direction direction, const tile_map<p_width,p_height>& p_tile_map, const float tick_seconds)
+    {
+      move_requests[player_id].velocity = sf::Vector2f(0.0f, 0.0f);
+
+      chamber.hold(direction);
+      chamber.generate_move_request(player_id, *predicted_entities, *predicted_moves, p_tile_map, move_requests);
+
+      predicted_moves->submit_all_moves(move_requests, p_tile_map, *predicted_entities);
+      predicted_moves->update_by_velocities(tick_seconds, p_tile_map, *predicted_entities);
+      predicted_entities->set_all_positions(predicted_moves->current_origin_x, predicted_moves->current_origin_y);
+    }
+
+    void rewind(const world_snapshot& snapshot, const tile_map<p_width,p_height>& p_tile_map, const float tick_seconds)
+    {
+      // @optimize: rebuilds every entity, could keep stationary entities that didn't change in the snapshot
+      for(int live_index=predicted_entities->live_count - 1; live_index >= 0; --live_index)
+      {
+        int id = predicted_entities->live_ids[live_index];
+        predicted_moves->remove_entity(id, p_tile_map);
+        predicted_entities->despawn(predicted_entities->handle_of(id));
+      }
+
+      const sf::Vector2f collision_size(p_tile_map.tile_size_x - 2.0f, p_tile_map.tile_size_y - 2.0f);
+
+      for(int present_index=0; present_index < snapshot.present_count; ++present_index)
+      {
+        const int id = snapshot.present_ids[present_index];
+        const snapshot_entity& entity = snapshot.entities[id];
+        if ( (id >= p_max_size) || (entity.tile_index >= p_tile_map.tile_count) ) continue;
+
+        // the tile the entity is on or moving to
+        const sf::Vector2f tile_origin_position( (p_tile_map.tile_size_x * (entity.tile_index % p_tile_map.width)) + 1.0f, (p_tile_map.tile_size_y * (entity.tile_index / p_tile_map.width)) + 1.0f );
+
+        if ( (id == player_id) && entity.is_moving )
+        {
+          // @remember: assumes the player moves at its own speed, a player pushing a chain moves slower on the server until the next STATE corrects it
+          static const player_input_direction move_directions[] = { player_input_direction::LEFT, player_input_direction::RIGHT, player_input_direction::UP, player_input_direction::DOWN };
+          const sf::Vector2f velocity = player_velocity_from_input(move_directions[static_cast<int>(entity.direction)], p_tile_map);
+
+          // redo the server's steps from the previous tile instead of using the quantized position, the float sum decides the tick the move arrives on
+          const sf::Vector2f previous_tile_origin_position = tile_origin_position - sf::Vector2f( (velocity.x > 0) ? p_tile_map.tile_size_x : ((velocity.x < 0) ? -p_tile_map.tile_size_x : 0.0f),
+                                                                                                 (velocity.y > 0) ? p_tile_map.tile_size_y : ((velocity.y < 0) ? -p_tile_map.tile_size_y : 0.0f) );
+          const sf::Vector2f travelled = dequantize_origin_position(entity, p_tile_map) - previous_tile_origin_position;
+          const float        step      = std::abs(velocity.x + velocity.y) * tick_seconds;
+          const int          step_count = static_cast<int>( std::lround(std::abs(travelled.x + travelled.y) / step) );
+
+          sf::Vector2f origin_position = previous_tile_origin_position;
+          for(int i=0; i < step_count; ++i)
+          {
+            origin_position.x = origin_position.x + (velocity.x * tick_seconds);
+            origin_position.y = origin_position.y + (velocity.y * tick_seconds);
+          }
+
+          predicted_entities->spawn_with_id(id, entity.type, origin_position, collision_size);
+          predicted_moves->add_moving_entity(id, origin_position, tile_origin_position, velocity, p_tile_map);
+        }
+        else
+        {
+          predicted_entities->spawn_with_id(id, entity.type, tile_origin_position, collision_size);
+          predicted_moves->add_entity(id, tile_origin_position, p_tile_map);
+        }
+
+        move_requests[id].velocity = sf::Vector2f(0.0f, 0.0f);
+      }
+    }
+};
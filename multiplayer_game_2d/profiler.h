@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "histogram.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+  #define PROFILER_USE_TSC
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #else
+    #include <x86intrin.h>
+  #endif
+#endif
+
+
+/*
+   @remember: PROFILE_ZONE("name") times the rest of its scope into the calling thread's ring buffer, names must be string literals (only the pointer is stored) without quotes or backslashes
+   @remember: a zone is two timestamp counter reads and one ring write (~20-40 ns) so zones stay on in release builds, define PROFILER_DISABLED to compile them out
+   @remember: zones are timed in raw rdtsc ticks (steady_clock where there's no rdtsc, ~40 ns a read) and converted to time when the trace is written, this assumes an invariant TSC like every x86 CPU of the last decade has
+   @remember: each thread keeps its newest PROFILER_RING_SIZE zones, rings are never freed so a trace can still be written after their threads exit
+   @remember: write the trace once the profiled threads are done (e.g. at exit), zones recorded while writing may come out torn
+   @remember: PROFILE_TICK_PHASE(histograms, phase) is a zone that also records its duration into a tick_time_histograms (when not null), so per-system tick time percentiles come from the same timestamps as the trace
+   @remember: the game and the server (live, replay and multi-match modes) write a Chrome trace (chrome://tracing or ui.perfetto.dev) at exit when the PROFILER_TRACE environment variable names a file, the other tools have no zones and ignore it
+*/
+
+
+#define PROFILER_RING_SIZE    65536   // zones kept per thread, must be a power of two
+#define PROFILER_MAX_THREADS  256
+
+
+
+/* ring stuff */
+struct profile_event
+{
+  const char*  name           = nullptr;
+  std::int64_t start_ticks    = 0;
+  std::int64_t duration_ticks = 0;
+};
+
+struct profile_ring  // one thread's zones, only that thread writes
+{
+  profile_event              events[PROFILER_RING_SIZE];
+  std::atomic<std::uint64_t> write_count{0};        // zones ever recorded, the newest is at (write_count - 1) % PROFILER_RING_SIZE
+  const char*                thread_name  = nullptr;
+  int                        thread_index = 0;
+};
+
+struct profiler_registry
+{
+  std::mutex    mutex;
+  profile_ring* rings[PROFILER_MAX_THREADS] = {};
+  int           ring_count = 0;
+  std::int64_t  calibration_ns;      // steady_clock and ticks read together at startup, the trace's tick to ns ratio is measured from here
+  std::int64_t  calibration_ticks;
+
+  profiler_registry();
+};
+
+inline profiler_registry& get_profiler_registry()
+{
+  static profiler_registry registry;
+  return registry;
+}
+
+inline std::int64_t profiler_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+inline std::int64_t profiler_now_ticks()
+{
+  #ifdef PROFILER_USE_TSC
+    return static_cast<std::int64_t>(__rdtsc());
+  #else
+    return profiler_now_ns();
+  #endif
+}
+
+inline profiler_registry::profiler_registry() : calibration_ns(profiler_now_ns()), calibration_ticks(profiler_now_ticks()) {}
+
+inline double profiler_microseconds_per_tick()  // measured since the first zone, call once some time has passed (e.g. when reporting)
+{
+  const profiler_registry& registry = get_profiler_registry();
+  const std::int64_t elapsed_ticks = profiler_now_ticks() - registry.calibration_ticks;
+  const std::int64_t elapsed_ns    = profiler_now_ns()    - registry.calibration_ns;
+  return (elapsed_ticks > 0) ? (static_cast<double>(elapsed_ns) / static_cast<double>(elapsed_ticks) / 1000.0) : 0.001;
+}
+
+inline profile_ring* create_profile_ring()  // nullptr once PROFILER_MAX_THREADS threads have profiled, their zones are then dropped
+{
+  profiler_registry& registry = get_profiler_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (registry.ring_count == PROFILER_MAX_THREADS) return nullptr;
+
+  profile_ring* ring = new profile_ring();
+  ring->thread_index = registry.ring_count;
+  registry.rings[registry.ring_count] = ring;
+  ++registry.ring_count;
+  return ring;
+}
+
+inline profile_ring* get_thread_profile_ring()
+{
+  thread_local profile_ring* ring = create_profile_ring();
+  return ring;
+}
+
+inline void profiler_name_thread(const char* const name)  // shown as the thread's name in the trace, a string literal
+{
+  profile_ring* ring = get_thread_profile_ring();
+  if (ring) ring->thread_name = name;
+}
+
+
+
+/* zone stuff */
+struct profile_zone
+{
+  const char* const        name;
+  latency_histogram* const histogram;   // also gets the duration when not null
+  const std::int64_t       start_ticks;
+
+  explicit profile_zone(const char* const p_name, latency_histogram* const p_histogram = nullptr) : name(p_name), histogram(p_histogram), start_ticks(profiler_now_ticks()) {}
+
+  profile_zone(const profile_zone&) = delete;
+  profile_zone& operator=(const profile_zone&) = delete;
+
+  ~profile_zone()
+  {
+    const std::int64_t end_ticks = profiler_now_ticks();
+    if (histogram) histogram->record( static_cast<std::uint64_t>(end_ticks - start_ticks) );
+
+    profile_ring* ring = get_thread_profile_ring();
+    if (!ring) return;
+
+    const std::uint64_t index = ring->write_count.load(std::memory_order_relaxed);
+    profile_event& event = ring->events[index & (PROFILER_RING_SIZE - 1)];
+    event.name           = name;
+    event.start_ticks    = start_ticks;
+    event.duration_ticks = end_ticks - start_ticks;
+    ring->write_count.store(index + 1, std::memory_order_release);
+  }
+};
+
+#define PROFILE_CONCATENATE_INNER(a, b)  a##b
+#define PROFILE_CONCATENATE(a, b)        PROFILE_CONCATENATE_INNER(a, b)
+
+#ifdef PROFILER_DISABLED
+  #define PROFILE_ZONE(name)                     ((void)0)
+  #define PROFILE_TICK_PHASE(histograms, phase)  ((void)0)
+#else
+  #define PROFILE_ZONE(name)                     profile_zone PROFILE_CONCATENATE(profile_zone_, __LINE__)(name)
+  #define PROFILE_TICK_PHASE(histograms, phase)  profile_zone PROFILE_CONCATENATE(profile_zone_, __LINE__)( tick_phase_names[static_cast<int>(phase)], (histograms) ? &(histograms)->phases[static_cast<int>(phase)] : nullptr )
+#endif
+
+
+
+/* trace stuff */
+inline bool write_chrome_trace(const char* const path)  // every thread's kept zones as complete ("X") events, timestamps in us from the earliest kept zone
+{
+  FILE* file = fopen(path, "w");
+  if (!file) return false;
+
+  profiler_registry& registry = get_profiler_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  const double us_per_tick = profiler_microseconds_per_tick();
+
+  std::int64_t origin_ticks = INT64_MAX;
+  for(int i=0; i < registry.ring_count; ++i)
+  {
+    const profile_ring& ring = *registry.rings[i];
+    const std::uint64_t count = ring.write_count.load(std::memory_order_acquire);
+    const std::uint64_t first = (count > PROFILER_RING_SIZE) ? (count - PROFILER_RING_SIZE) : 0;
+    if ( (count > first) && (ring.events[first & (PROFILER_RING_SIZE - 1)].start_ticks < origin_ticks) ) origin_ticks = ring.events[first & (PROFILER_RING_SIZE - 1)].start_ticks;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool is_first_event = true;
+
+  for(int i=0; i < registry.ring_count; ++i)
+  {
+    const profile_ring& ring = *registry.rings[i];
+
+    if (ring.thread_name)
+    {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", is_first_event ? "" : ",\n", ring.thread_index, ring.thread_name);
+      is_first_event = false;
+    }
+
+    const std::uint64_t count = ring.write_count.load(std::memory_order_acquire);
+    const std::uint64_t first = (count > PROFILER_RING_SIZE) ? (count - PROFILER_RING_SIZE) : 0;
+    for(std::uint64_t index=first; index < count; ++index)
+    {
+      const profile_event& event = ring.events[index & (PROFILER_RING_SIZE - 1)];
+      fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", is_first_event ? "" : ",\n", event.name, ring.thread_index,
+              static_cast<double>(event.start_ticks - origin_ticks) * us_per_tick, static_cast<double>(event.duration_ticks) * us_per_tick);
+      is_first_event = false;
+    }
+  }
+
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
+
+inline void write_chrome_trace_if_requested()  // call at exit
+{
+  const char* path = getenv("PROFILER_TRACE");
+  if ( !path || !path[0] ) return;
+
+  if (write_chrome_trace(path)) printf("wrote profiler trace to %s\n", path);
+  else                          printf("could not write profiler trace to %s\n", path);
+}
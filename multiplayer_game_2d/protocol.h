@@ -0,0 +1,322 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+#include "net.h"
+#include "gameplay.h"
+#include "snapshot.h"
+
+
+/*
+   @remember: every packet starts with PROTOCOL_ID (u32) then a packet_type (u8), everything is little-endian
+   @remember: clients send CONNECT_REQUEST until accepted then INPUT every client tick, the server sends STATE to every client each server tick
+   @remember: INPUT acks the newest STATE the client decoded and STATE is a delta against the newest acked one (see snapshot.h)
+   @remember: the server applies one input per tick in sequence order and clients tick at the server's tick_rate so client prediction can replay inputs tick for tick
+   @remember: STATE carries the hash of the snapshot the client should have after decoding it, INPUT reports the first tick where it didn't (see state_hash.h)
+*/
+
+
+#define PROTOCOL_ID                   0x4D473244u  // "MG2D", drops stray datagrams
+#define DEFAULT_SERVER_PORT           40000
+#define MAX_CLIENTS                   16
+#define CONNECTION_TIMEOUT_SECONDS    5.0f         // a peer that sends nothing for this long is disconnected
+#define CONNECT_RETRY_SECONDS         0.25f
+#define INPUT_REDUNDANCY              4            // each INPUT carries the newest inputs so a lost datagram doesn't lose input
+#define INPUT_BUFFER_SIZE             64           // inputs the server buffers per client, must be a power of two
+#define MAX_INPUT_BACKLOG             8            // buffered inputs past this are skipped so input latency stays bounded
+#define INPUT_BUFFER_DELAY            2            // inputs buffered before the server starts applying them, absorbs arrival jitter so ticks without input (mispredictions) are rare
+#define PACKET_HEADER_SIZE            5
+#define STATE_HEADER_SIZE             (PACKET_HEADER_SIZE + 4 + 4 + 4 + 1 + 4)
+#define STATE_MAX_DELTA_BITS          ((NET_MAX_PACKET_SIZE - STATE_HEADER_SIZE) * 8)
+
+
+
+/* serialization stuff */
+struct byte_writer
+{
+  std::uint8_t* const data;
+  const int capacity;
+  int  size       = 0;
+  bool overflowed = false;  // set instead of writing out of bounds, check before sending
+
+  byte_writer(std::uint8_t* const p_data, const int p_capacity) : data(p_data), capacity(p_capacity) {}
+
+  void write_u8(const std::uint8_t value)
+  {
+    if (size + 1 > capacity) { overflowed = true; return; }
+    data[size] = value;
+    ++size;
+  }
+
+  void write_u16(const std::uint16_t value)
+  {
+    write_u8(static_cast<std::uint8_t>(value));
+    write_u8(static_cast<std::uint8_t>(value >> 8));
+  }
+
+  void write_u32(const std::uint32_t value)
+  {
+    write_u16(static_cast<std::uint16_t>(value));
+    write_u16(static_cast<std::uint16_t>(value >> 16));
+  }
+
+  void write_f32(const float value)
+  {
+    std::uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u32(bits);
+  }
+};
+
+struct byte_reader
+{
+  const std::uint8_t* const data;
+  const int size;
+  int  position   = 0;
+  bool overflowed = false;  // set when reading past the end, values read after that are 0
+
+  byte_reader(const std::uint8_t* const p_data, const int p_size) : data(p_data), size(p_size) {}
+
+  std::uint8_t read_u8()
+  {
+    if (position + 1 > size) { overflowed = true; return 0; }
+    std::uint8_t value = data[position];
+    ++position;
+    return value;
+  }
+
+  std::uint16_t read_u16()
+  {
+    std::uint16_t low = read_u8();
+    return static_cast<std::uint16_t>( low | (static_cast<std::uint16_t>(read_u8()) << 8) );
+  }
+
+  std::uint32_t read_u32()
+  {
+    std::uint32_t low = read_u16();
+    return low | (static_cast<std::uint32_t>(read_u16()) << 16);
+  }
+
+  float read_f32()
+  {
+    std::uint32_t bits = read_u32();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+
+
+
+/* packet stuff */
+inline bool sequence_greater_than(const std::uint32_t a, const std::uint32_t b)  // wrap-around safe
+{
+  return static_cast<std::int32_t>(a - b) > 0;
+}
+
+enum class packet_type : std::uint8_t
+{
+  CONNECT_REQUEST = 0,
+  CONNECT_ACCEPT  = 1,
+  CONNECT_DENIED  = 2,   // server is full
+  DISCONNECT      = 3,
+  INPUT           = 4,
+  STATE           = 5
+};
+
+inline void write_packet_header(byte_writer& writer, const packet_type type)
+{
+  writer.write_u32(PROTOCOL_ID);
+  writer.write_u8(static_cast<std::uint8_t>(type));
+}
+
+inline bool read_packet_header(byte_reader& reader, packet_type& type)  // false for datagrams that aren't ours
+{
+  if (reader.read_u32() != PROTOCOL_ID) return false;
+
+  std::uint8_t raw_type = reader.read_u8();
+  if ( reader.overflowed || (raw_type > static_cast<std::uint8_t>(packet_type::STATE)) ) return false;
+
+  type = static_cast<packet_type>(raw_type);
+  return true;
+}
+
+struct connect_accept_message
+{
+  int           entity_id       = -1;    // the entity the client controls
+  std::uint16_t tick_rate       = 0;     // server ticks per second
+  std::uint16_t map_width       = 0;
+  std::uint16_t map_height      = 0;
+  std::uint32_t entity_capacity = 0;     // server entity ids are below this
+  float         tile_size_x     = 0.0f;  // server world units per tile, positions are sent in tiles so clients only need this for their own map
+  float         tile_size_y     = 0.0f;
+
+  void write(byte_writer& writer) const
+  {
+    writer.write_u32(static_cast<std::uint32_t>(entity_id));
+    writer.write_u16(tick_rate);
+    writer.write_u16(map_width);
+    writer.write_u16(map_height);
+    writer.write_u32(entity_capacity);
+    writer.write_f32(tile_size_x);
+    writer.write_f32(tile_size_y);
+  }
+
+  bool read(byte_reader& reader)
+  {
+    entity_id       = static_cast<int>(reader.read_u32());
+    tick_rate       = reader.read_u16();
+    map_width       = reader.read_u16();
+    map_height      = reader.read_u16();
+    entity_capacity = reader.read_u32();
+    tile_size_x     = reader.read_f32();
+    tile_size_y     = reader.read_f32();
+    return !reader.overflowed;
+  }
+
+  snapshot_layout layout() const { return snapshot_layout(static_cast<std::uint32_t>(map_width) * map_height, entity_capacity); }
+};
+
+struct input_message
+{
+  std::uint32_t          acked_state_tick = 0;              // newest STATE the client decoded, 0 for none
+  std::uint32_t          newest_sequence  = 0;              // sequence of directions[0], directions[i] has sequence newest_sequence - i
+  std::uint32_t          desync_tick      = 0;              // first STATE whose hash didn't match what the client decoded, 0 for none
+  int                    direction_count  = 0;
+  player_input_direction directions[INPUT_REDUNDANCY];      // newest first
+
+  void write(byte_writer& writer) const
+  {
+    writer.write_u32(acked_state_tick);
+    writer.write_u32(newest_sequence);
+    writer.write_u32(desync_tick);
+    writer.write_u8(static_cast<std::uint8_t>(direction_count));
+    for(int i=0; i < direction_count; ++i) writer.write_u8(static_cast<std::uint8_t>(directions[i]));
+  }
+
+  bool read(byte_reader& reader)
+  {
+    acked_state_tick = reader.read_u32();
+    newest_sequence  = reader.read_u32();
+    desync_tick      = reader.read_u32();
+    direction_count  = reader.read_u8();
+    if (direction_count > INPUT_REDUNDANCY) return false;
+
+    for(int i=0; i < direction_count; ++i)
+    {
+      std::uint8_t raw_direction = reader.read_u8();
+      if (raw_direction > static_cast<std::uint8_t>(player_input_direction::DOWN)) return false;
+      directions[i] = static_cast<player_input_direction>(raw_direction);
+    }
+
+    return !reader.overflowed;
+  }
+};
+
+struct input_buffer  // server side, the inputs of one client by sequence
+{
+  std::uint32_t newest_sequence  = 0;            // newest received
+  std::uint32_t applied_sequence = 0;            // newest applied (what STATE acks)
+  long long     starved_count    = 0;            // ticks the next input hadn't arrived yet
+
+  private:
+    std::uint32_t          sequences[INPUT_BUFFER_SIZE] = {};
+    player_input_direction directions[INPUT_BUFFER_SIZE];
+    bool                   is_draining = false;  // false while refilling up to INPUT_BUFFER_DELAY
+  public:
+
+  void receive(const input_message& input)
+  {
+    for(int i=0; i < input.direction_count; ++i)
+    {
+      std::uint32_t sequence = input.newest_sequence - static_cast<std::uint32_t>(i);
+      if ( !sequence_greater_than(sequence, applied_sequence) ) break;
+
+      sequences[sequence & (INPUT_BUFFER_SIZE - 1)]  = sequence;
+      directions[sequence & (INPUT_BUFFER_SIZE - 1)] = input.directions[i];
+    }
+
+    if ( sequence_greater_than(input.newest_sequence, newest_sequence) ) newest_sequence = input.newest_sequence;
+  }
+
+  player_input_direction next_direction()  // call once per tick, NONE (keep the chamber) when the next input hasn't arrived yet
+  {
+    if ( !sequence_greater_than(newest_sequence, applied_sequence) )
+    {
+      if (is_draining) ++starved_count;
+      is_draining = false;
+      return player_input_direction::NONE;
+    }
+
+    if ( !is_draining && ((newest_sequence - applied_sequence) < INPUT_BUFFER_DELAY) ) return player_input_direction::NONE;
+    is_draining = true;
+
+    if ( (newest_sequence - applied_sequence) > MAX_INPUT_BACKLOG ) applied_sequence = newest_sequence - MAX_INPUT_BACKLOG;  // drop the oldest
+
+    std::uint32_t sequence = applied_sequence + 1;
+    int           index    = sequence & (INPUT_BUFFER_SIZE - 1);
+
+    if (sequences[index] == sequence)
+    {
+      applied_sequence = sequence;
+      return directions[index];
+    }
+
+    // every INPUT that could have carried it has been superseded so it was lost
+    if ( (newest_sequence - sequence) >= INPUT_REDUNDANCY ) applied_sequence = sequence;
+    return player_input_direction::NONE;
+  }
+};
+
+struct state_message  // header of a STATE, the bit-packed delta follows it
+{
+  std::uint32_t tick                 = 0;
+  std::uint32_t baseline_tick        = 0;        // the delta is against this tick, 0 is the initial match state
+  std::uint32_t acked_input_sequence = 0;        // newest input from this client the server has applied
+  player_input_direction acked_chamber_direction = player_input_direction::NONE;  // the client's move chamber after that input, lets prediction rewind it
+  std::uint32_t state_hash           = 0;        // low bits of the hash of the snapshot the client has after decoding, write computes it from sent
+
+  void write(byte_writer& writer, const world_snapshot& baseline, const world_snapshot& current, world_snapshot& sent, const snapshot_layout& layout) const  // sent is filled with what the client will have, see write_snapshot_delta
+  {
+    writer.write_u32(tick);
+    writer.write_u32(baseline_tick);
+    writer.write_u32(acked_input_sequence);
+    writer.write_u8(static_cast<std::uint8_t>(acked_chamber_direction));
+    const int hash_position = writer.size;
+    writer.write_u32(0);  // sent is only known once the delta is written
+    if (writer.overflowed) return;
+
+    bit_writer bits(writer.data + writer.size, writer.capacity - writer.size);
+    write_snapshot_delta(bits, baseline, current, sent, layout, (writer.capacity - writer.size) * 8);
+    bits.flush();
+
+    writer.size += bits.size;
+    if (bits.overflowed) writer.overflowed = true;
+
+    byte_writer hash_writer(writer.data + hash_position, 4);
+    hash_writer.write_u32( static_cast<std::uint32_t>(sent.hash()) );
+  }
+
+  bool read_header(byte_reader& reader)
+  {
+    tick                 = reader.read_u32();
+    baseline_tick        = reader.read_u32();
+    acked_input_sequence = reader.read_u32();
+
+    std::uint8_t raw_direction = reader.read_u8();
+    if (raw_direction > static_cast<std::uint8_t>(player_input_direction::DOWN)) return false;
+    acked_chamber_direction = static_cast<player_input_direction>(raw_direction);
+    state_hash              = reader.read_u32();
+
+    return !reader.overflowed;
+  }
+
+  bool read_snapshot(byte_reader& reader, const world_snapshot& baseline, world_snapshot& snapshot, const snapshot_layout& layout) const  // call after read_header with the baseline_tick snapshot
+  {
+    bit_reader bits(reader.data + reader.position, reader.size - reader.position);
+    if ( !read_snapshot_delta(bits, baseline, snapshot, tick, layout) ) return false;
+
+    reader.position += bits.position;
+    return true;
+  }
+};
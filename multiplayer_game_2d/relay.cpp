@@ -0,0 +1,375 @@
+#include <iostream>
+#include <string.h>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <memory>
+#include <assert.h>
+#include "net.h"
+#include "protocol.h"
+
+
+/*
+   @remember: headless UDP relay that sits between clients and a server and impairs the datagrams going through it, for testing networked play without a real network
+   @remember: every client gets its own upstream socket so the server still sees one address per client
+   @remember: latency, jitter and loss apply to each direction separately, so the round trip gets twice the latency
+   @remember: jitter alone keeps each direction in order (like most real links), only the reorder chance lets datagrams overtake each other
+   @remember: a reordered datagram is held back reorder_delay ms, longer than the 33 ms between a 30 Hz stream's datagrams so the next ones overtake it, and is only counted as reordered when one actually did
+*/
+
+
+#define RELAY_MAX_SESSIONS         64
+#define RELAY_SESSION_TIMEOUT      (CONNECTION_TIMEOUT_SECONDS * 2.0f)  // sessions outlive the server's own timeout so the server notices first
+#define RELAY_REORDER_DELAY_MS     100.0f // default extra delay of a held back datagram, a few 30 Hz intervals so later datagrams overtake it
+#define RELAY_MAX_PENDING          4096   // datagrams held at once, more are dropped
+#define RELAY_MAX_PHASES           16
+#define RELAY_POLL_SECONDS         0.0005f
+
+
+
+/* impairment stuff */
+struct impairment_settings
+{
+  float latency_ms        = 0.0f;
+  float jitter_ms         = 0.0f;   // uniform extra delay in [0, jitter_ms]
+  float loss_percent      = 0.0f;
+  float duplicate_percent = 0.0f;
+  float reorder_percent   = 0.0f;
+  float reorder_delay_ms  = RELAY_REORDER_DELAY_MS;
+
+  bool set(const char* const key, const float value)  // false for unknown keys
+  {
+    if      (strcmp(key, "latency")       == 0) latency_ms        = value;
+    else if (strcmp(key, "jitter")        == 0) jitter_ms         = value;
+    else if (strcmp(key, "loss")          == 0) loss_percent      = value;
+    else if (strcmp(key, "duplicate")     == 0) duplicate_percent = value;
+    else if (strcmp(key, "reorder")       == 0) reorder_percent   = value;
+    else if (strcmp(key, "reorder_delay") == 0) reorder_delay_ms  = value;
+    else return false;
+    return true;
+  }
+
+  void print() const
+  {
+    std::cout << "latency " << latency_ms << " ms, jitter " << jitter_ms << " ms, loss " << loss_percent << "%, duplicate " << duplicate_percent << "%, reorder " << reorder_percent << "% held back " << reorder_delay_ms << " ms";
+  }
+};
+
+struct impairment_phase
+{
+  float               start_seconds = 0.0f;
+  impairment_settings settings;
+};
+
+inline int parse_impairment_script(const char* const script, impairment_phase* const phases)  // "seconds:key=value,key=value;seconds:..." each phase changes only the keys it lists, returns the phase count or -1 (also when the first phase isn't at 0 or start times don't increase)
+{
+  int  phase_count = 0;
+  impairment_settings settings;
+
+  const char* cursor = script;
+  while (*cursor)
+  {
+    if (phase_count == RELAY_MAX_PHASES) return -1;
+
+    char* end;
+    const float start_seconds = static_cast<float>(strtod(cursor, &end));
+    if ( (end == cursor) || (*end != ':') ) return -1;
+    if ( (phase_count == 0) ? (start_seconds != 0.0f) : (start_seconds <= phases[phase_count - 1].start_seconds) ) return -1;
+    cursor = end + 1;
+
+    while ( *cursor && (*cursor != ';') )
+    {
+      char key[16];
+      int  key_size = 0;
+      while ( *cursor && (*cursor != '=') && (key_size < static_cast<int>(sizeof(key)) - 1) ) key[key_size++] = *cursor++;
+      key[key_size] = '\0';
+      if (*cursor != '=') return -1;
+      ++cursor;
+
+      const float value = static_cast<float>(strtod(cursor, &end));
+      if ( (end == cursor) || (value < 0.0f) || !settings.set(key, value) ) return -1;
+      cursor = end;
+      if (*cursor == ',') ++cursor;
+    }
+    if (*cursor == ';') ++cursor;
+
+    phases[phase_count].start_seconds = start_seconds;
+    phases[phase_count].settings      = settings;
+    ++phase_count;
+  }
+
+  return phase_count;
+}
+
+struct impairment_stats  // one direction
+{
+  long long received_count   = 0;
+  long long delivered_count  = 0;
+  long long lost_count       = 0;
+  long long duplicated_count = 0;
+  long long held_back_count  = 0;   // picked by the reorder chance
+  long long reordered_count  = 0;   // delivered after a datagram that arrived later
+  long long overflow_count   = 0;   // dropped because RELAY_MAX_PENDING datagrams were already held
+};
+
+
+
+/* relay stuff */
+struct relay_session
+{
+  bool                         is_active  = false;
+  long long                    generation = 0;          // tells pending datagrams of a timed out session from those of the client reusing its slot
+  net_address                  client_address;
+  std::unique_ptr<udp_socket>  upstream;                // talks to the server for this client
+  float                        seconds_since_receive = 0.0f;
+  double                       last_delivery_ms[2]   = { 0.0, 0.0 };  // newest in-order delivery time per direction, keeps jitter from reordering
+  long long                    next_sequence[2]      = { 0, 0 };      // arrival order per direction
+  long long                    newest_delivered[2]   = { -1, -1 };    // newest sequence delivered per direction, anything older delivered after it was overtaken
+};
+
+enum relay_direction : int
+{
+  RELAY_TO_SERVER = 0,
+  RELAY_TO_CLIENT = 1
+};
+
+struct relay_packet
+{
+  double       delivery_ms = 0.0;
+  int          session     = -1;
+  long long    generation  = 0;
+  long long    sequence    = 0;     // duplicates share their original's
+  int          direction   = RELAY_TO_SERVER;
+  int          size        = 0;
+  std::uint8_t data[NET_MAX_PACKET_SIZE];
+};
+
+
+
+int main(int argc, char** argv)
+{
+  const int   listen_port = (argc > 1) ? atoi(argv[1])                       : DEFAULT_SERVER_PORT + 1;
+  const char* server_ip   = (argc > 2) ? argv[2]                             : "127.0.0.1";
+  const int   server_port = (argc > 3) ? atoi(argv[3])                       : DEFAULT_SERVER_PORT;
+  const float run_seconds = (argc > 4) ? static_cast<float>(atof(argv[4]))   : 0.0f;   // 0 runs forever
+  const char* script      = (argc > 5) ? argv[5]                             : "0:latency=50,jitter=10,loss=2";
+  const unsigned int seed = (argc > 6) ? static_cast<unsigned int>(atoi(argv[6])) : 1;
+
+  impairment_phase phases[RELAY_MAX_PHASES];
+  const int phase_count = parse_impairment_script(script, phases);
+
+  net_address server_address;
+  if ( (phase_count < 1) || !server_address.parse(server_ip, static_cast<std::uint16_t>(server_port)) )
+  {
+    std::cout << "usage: relay [listen_port] [server_ip] [server_port] [run_seconds] [\"seconds:key=value,...;seconds:...\"] [seed]" << std::endl
+              << "keys: latency, jitter, reorder_delay (ms per direction), loss, duplicate, reorder (percent), each phase keeps the values it doesn't list, the first phase starts at 0 and start times increase" << std::endl;
+    return 1;
+  }
+
+  udp_socket listen_socket;
+  if ( !net_startup() || !listen_socket.open(static_cast<std::uint16_t>(listen_port)) )
+  {
+    std::cout << "could not open udp port " << listen_port << std::endl;
+    return 1;
+  }
+
+  relay_session* sessions = new relay_session[RELAY_MAX_SESSIONS];
+  std::unique_ptr<net_packet_batch> incoming(new net_packet_batch());
+
+  // pending datagrams live in a fixed pool, the queue orders pool slots by delivery time
+  std::unique_ptr<relay_packet[]> pending(new relay_packet[RELAY_MAX_PENDING]);
+  std::vector<int> free_slots;
+  for(int slot=RELAY_MAX_PENDING - 1; slot >= 0; --slot) free_slots.push_back(slot);
+
+  typedef std::pair<double,int> delivery;  // delivery_ms, slot
+  std::priority_queue<delivery, std::vector<delivery>, std::greater<delivery>> deliveries;
+
+  std::mt19937 random_generator(seed);
+  std::uniform_real_distribution<float> percent_distribution(0.0f, 100.0f);
+  impairment_stats stats[2];
+  int phase_index = 0;
+  long long session_generation = 0;
+
+  std::cout << "relay on udp port " << listen_port << " to " << server_ip << ":" << server_port << ", phase at 0 s: ";
+  phases[0].settings.print();
+  std::cout << std::endl;
+
+  std::chrono::steady_clock::time_point start_time    = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point previous_time = start_time;
+
+  auto impair = [&](const int session, const int direction, const std::uint8_t* const data, const int size, const double now_ms)
+  {
+    const impairment_settings& settings = phases[phase_index].settings;
+    ++stats[direction].received_count;
+
+    if (percent_distribution(random_generator) < settings.loss_percent)
+    {
+      ++stats[direction].lost_count;
+      return;
+    }
+
+    const int copy_count = (percent_distribution(random_generator) < settings.duplicate_percent) ? 2 : 1;
+    if (copy_count == 2) ++stats[direction].duplicated_count;
+
+    const long long sequence = sessions[session].next_sequence[direction];
+    ++sessions[session].next_sequence[direction];
+
+    for(int copy=0; copy < copy_count; ++copy)
+    {
+      if (free_slots.empty())
+      {
+        ++stats[direction].overflow_count;
+        return;
+      }
+
+      double delivery_ms = now_ms + settings.latency_ms + (settings.jitter_ms * percent_distribution(random_generator) / 100.0f);
+      if (percent_distribution(random_generator) < settings.reorder_percent)
+      {
+        delivery_ms += settings.reorder_delay_ms;  // doesn't hold back later datagrams, they overtake it
+        ++stats[direction].held_back_count;
+      }
+      else
+      {
+        if (delivery_ms < sessions[session].last_delivery_ms[direction]) delivery_ms = sessions[session].last_delivery_ms[direction];
+        sessions[session].last_delivery_ms[direction] = delivery_ms;
+      }
+
+      const int slot = free_slots.back();
+      free_slots.pop_back();
+
+      relay_packet& packet = pending[slot];
+      packet.delivery_ms = delivery_ms;
+      packet.session     = session;
+      packet.generation  = sessions[session].generation;
+      packet.sequence    = sequence;
+      packet.direction   = direction;
+      packet.size        = size;
+      memcpy(packet.data, data, static_cast<size_t>(size));
+      deliveries.push(delivery(delivery_ms, slot));
+    }
+  };
+
+  for(;;)
+  {
+    std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+    float elapsed_frame_time_seconds = std::chrono::duration<float>(current_time - previous_time).count();
+    previous_time = current_time;
+
+    const float  elapsed_seconds = std::chrono::duration<float>(current_time - start_time).count();
+    const double now_ms          = std::chrono::duration<double,std::milli>(current_time - start_time).count();
+    if ( (run_seconds > 0.0f) && (elapsed_seconds >= run_seconds) ) break;
+
+    if ( (phase_index + 1 < phase_count) && (elapsed_seconds >= phases[phase_index + 1].start_seconds) )
+    {
+      ++phase_index;
+      std::cout << "phase at " << phases[phase_index].start_seconds << " s: ";
+      phases[phase_index].settings.print();
+      std::cout << std::endl;
+    }
+
+    // client to server, new client addresses open a session
+    while ( receive_batch(listen_socket, *incoming) > 0 )
+    {
+      for(int packet=0; packet < incoming->count; ++packet)
+      {
+        int session = -1;
+        int free_session = -1;
+        for(int i=0; i < RELAY_MAX_SESSIONS; ++i)
+        {
+          if (sessions[i].is_active && (sessions[i].client_address == incoming->addresses[packet])) session = i;
+          if (!sessions[i].is_active && (free_session == -1)) free_session = i;
+        }
+
+        if (session == -1)
+        {
+          if (free_session == -1) continue;
+
+          relay_session& new_session = sessions[free_session];
+          new_session.upstream.reset(new udp_socket());
+          if ( !new_session.upstream->open(0) ) continue;
+
+          ++session_generation;
+          new_session.is_active      = true;
+          new_session.generation     = session_generation;
+          new_session.client_address = incoming->addresses[packet];
+          new_session.last_delivery_ms[RELAY_TO_SERVER] = 0.0;
+          new_session.last_delivery_ms[RELAY_TO_CLIENT] = 0.0;
+          new_session.next_sequence[RELAY_TO_SERVER]    = 0;
+          new_session.next_sequence[RELAY_TO_CLIENT]    = 0;
+          new_session.newest_delivered[RELAY_TO_SERVER] = -1;
+          new_session.newest_delivered[RELAY_TO_CLIENT] = -1;
+          session = free_session;
+
+          char address_string[32];
+          new_session.client_address.to_string(address_string, sizeof(address_string));
+          std::cout << "relaying " << address_string << " through local port " << new_session.upstream->local_port() << std::endl;
+        }
+
+        sessions[session].seconds_since_receive = 0.0f;
+        impair(session, RELAY_TO_SERVER, incoming->buffers[packet], incoming->sizes[packet], now_ms);
+      }
+
+      if (incoming->count < NET_BATCH_SIZE) break;
+    }
+
+    // server to client
+    for(int i=0; i < RELAY_MAX_SESSIONS; ++i)
+    {
+      if (!sessions[i].is_active) continue;
+
+      while ( receive_batch(*sessions[i].upstream, *incoming) > 0 )
+      {
+        for(int packet=0; packet < incoming->count; ++packet)
+        {
+          if (incoming->addresses[packet] != server_address) continue;
+          impair(i, RELAY_TO_CLIENT, incoming->buffers[packet], incoming->sizes[packet], now_ms);
+        }
+
+        if (incoming->count < NET_BATCH_SIZE) break;
+      }
+
+      sessions[i].seconds_since_receive += elapsed_frame_time_seconds;
+      if (sessions[i].seconds_since_receive > RELAY_SESSION_TIMEOUT) sessions[i] = relay_session();  // its pending datagrams are dropped when due
+    }
+
+    // deliver what is due
+    while ( !deliveries.empty() && (deliveries.top().first <= now_ms) )
+    {
+      const int slot = deliveries.top().second;
+      deliveries.pop();
+
+      const relay_packet& packet = pending[slot];
+      relay_session& session = sessions[packet.session];
+      if ( session.is_active && (session.generation == packet.generation) )
+      {
+        if (packet.direction == RELAY_TO_SERVER) session.upstream->send(server_address, packet.data, packet.size);
+        else                                     listen_socket.send(session.client_address, packet.data, packet.size);
+        ++stats[packet.direction].delivered_count;
+
+        if (packet.sequence < session.newest_delivered[packet.direction]) ++stats[packet.direction].reordered_count;
+        else session.newest_delivered[packet.direction] = packet.sequence;
+      }
+
+      free_slots.push_back(slot);
+    }
+
+    std::this_thread::sleep_for( std::chrono::duration<float>(RELAY_POLL_SECONDS) );
+  }
+
+  const char* direction_names[] = { "client to server", "server to client" };
+  for(int direction=0; direction < 2; ++direction)
+  {
+    std::cout << direction_names[direction] << ": " << stats[direction].received_count << " datagrams, " << stats[direction].delivered_count << " delivered, " << stats[direction].lost_count << " lost, "
+              << stats[direction].duplicated_count << " duplicated, " << stats[direction].held_back_count << " held back, " << stats[direction].reordered_count << " reordered, " << stats[direction].overflow_count << " dropped on overflow" << std::endl;
+  }
+
+  delete[] sessions;
+  listen_socket.close();
+  net_shutdown();
+
+  return 0;
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <cstdint>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "gameplay.h"
+
+
+/*
+   @remember: a replay is everything a match can't regenerate itself: its seed and tile size, the entities spawned and despawned between ticks and the player move requests of each tick
+   @remember: the stress movers aren't recorded, they come from the match's random generator which the seed reproduces as long as playback makes the same calls in the same order
+   @remember: floats are stored as their bits and every tick ends with the match's state hash so playback can report the first tick that diverged
+   @remember: little-endian, one file per match: header then records until END_TICK of the last tick
+*/
+
+
+#define REPLAY_MAGIC    0x52324D47u  // "GM2R"
+#define REPLAY_VERSION  3            // 2: END_TICK carries match::state_hash(), 3: the header carries the tile size
+
+
+
+/* record stuff */
+enum class replay_record_type : std::uint8_t
+{
+  SPAWN        = 0,   // entity id, generation, type, origin, collision size
+  DESPAWN      = 1,   // entity id, generation
+  MOVE_REQUEST = 2,   // entity id, the whole gameplay_entity_move_request
+  END_TICK     = 3    // tick, match::state_hash()
+};
+
+struct replay_header
+{
+  std::uint32_t map_width       = 0;
+  std::uint32_t map_height      = 0;
+  std::uint32_t entity_capacity = 0;
+  std::uint32_t tick_rate       = 0;
+  std::uint32_t seed            = 0;
+  float         tile_size_x     = 0.0f;   // what the match was created with, movement is in world units so playback must use the same
+  float         tile_size_y     = 0.0f;
+};
+
+struct replay_record
+{
+  replay_record_type           type = replay_record_type::END_TICK;
+  gameplay_entity_handle       entity;
+  gameplay_entity_type         entity_type = gameplay_entity_type::NONE;
+  sf::Vector2f                 origin_position;
+  sf::Vector2f                 collision_size;
+  gameplay_entity_move_request move_request;
+  std::uint32_t                tick       = 0;
+  std::uint64_t                state_hash = 0;
+};
+
+
+
+/* writer stuff */
+struct replay_writer
+{
+  // @remember: records are buffered and written once per tick so recording costs one fwrite per tick
+
+  long long record_count = 0;
+
+  private:
+    FILE*                     file = nullptr;
+    std::vector<std::uint8_t> buffer;
+  public:
+
+  replay_writer() = default;
+  replay_writer(const replay_writer&) = delete;
+  replay_writer& operator=(const replay_writer&) = delete;
+  ~replay_writer() { close(); }
+
+  bool open(const char* const path, const replay_header& header)
+  {
+    close();
+    file = fopen(path, "wb");
+    if (!file) return false;
+
+    write_u32(REPLAY_MAGIC);
+    write_u32(REPLAY_VERSION);
+    write_u32(header.map_width);
+    write_u32(header.map_height);
+    write_u32(header.entity_capacity);
+    write_u32(header.tick_rate);
+    write_u32(header.seed);
+    write_f32(header.tile_size_x);
+    write_f32(header.tile_size_y);
+    return flush();
+  }
+
+  bool is_open() const { return file != nullptr; }
+
+  void close()
+  {
+    if (!file) return;
+    flush();
+    fclose(file);
+    file = nullptr;
+  }
+
+  void record_spawn(const gameplay_entity_handle handle, const gameplay_entity_type type, const sf::Vector2f& origin_position, const sf::Vector2f& collision_size)
+  {
+    write_u8(static_cast<std::uint8_t>(replay_record_type::SPAWN));
+    write_handle(handle);
+    write_u8(static_cast<std::uint8_t>(type));
+    write_vector(origin_position);
+    write_vector(collision_size);
+    ++record_count;
+  }
+
+  void record_despawn(const gameplay_entity_handle handle)
+  {
+    write_u8(static_cast<std::uint8_t>(replay_record_type::DESPAWN));
+    write_handle(handle);
+    ++record_count;
+  }
+
+  void record_move_request(const int id, const gameplay_entity_move_request& move_request)
+  {
+    write_u8(static_cast<std::uint8_t>(replay_record_type::MOVE_REQUEST));
+    write_u32(static_cast<std::uint32_t>(id));
+    write_vector(move_request.current_origin_position);
+    write_vector(move_request.destination_origin_position);
+    write_vector(move_request.velocity);
+    ++record_count;
+  }
+
+  bool end_tick(const std::uint32_t tick, const std::uint64_t state_hash)
+  {
+    write_u8(static_cast<std::uint8_t>(replay_record_type::END_TICK));
+    write_u32(tick);
+    write_u32(static_cast<std::uint32_t>(state_hash));
+    write_u32(static_cast<std::uint32_t>(state_hash >> 32));
+    ++record_count;
+    return flush();
+  }
+
+  private:
+    bool flush()
+    {
+      if ( !file || buffer.empty() ) return file != nullptr;
+
+      bool is_written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+      buffer.clear();
+      return is_written;
+    }
+
+    void write_u8(const std::uint8_t value) { buffer.push_back(value); }
+
+    void write_u32(const std::uint32_t value)
+    {
+      for(int shift=0; shift < 32; shift += 8) buffer.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+
+    void write_f32(const float value)
+    {
+      std::uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      write_u32(bits);
+    }
+
+    void write_vector(const sf::Vector2f& value)
+    {
+      write_f32(value.x);
+      write_f32(value.y);
+    }
+
+    void write_handle(const gameplay_entity_handle handle)
+    {
+      write_u32(static_cast<std::uint32_t>(handle.id));
+      write_u32(handle.generation);
+    }
+};
+
+
+
+/* reader stuff */
+struct replay_reader
+{
+  replay_header header;
+  bool          is_corrupt = false;   // set when a record is cut off or has an unknown type
+
+  private:
+    FILE* file = nullptr;
+  public:
+
+  replay_reader() = default;
+  replay_reader(const replay_reader&) = delete;
+  replay_reader& operator=(const replay_reader&) = delete;
+  ~replay_reader() { if (file) fclose(file); }
+
+  bool open(const char* const path)  // false for missing files and other formats or versions
+  {
+    file = fopen(path, "rb");
+    if (!file) return false;
+
+    if ( (read_u32() != REPLAY_MAGIC) || (read_u32() != REPLAY_VERSION) ) return false;
+    header.map_width       = read_u32();
+    header.map_height      = read_u32();
+    header.entity_capacity = read_u32();
+    header.tick_rate       = read_u32();
+    header.seed            = read_u32();
+    header.tile_size_x     = read_f32();
+    header.tile_size_y     = read_f32();
+    return !is_corrupt;
+  }
+
+  bool read(replay_record& record)  // false at the end of the file or when corrupt
+  {
+    int raw_type = fgetc(file);
+    if (raw_type == EOF) return false;
+    if (raw_type > static_cast<int>(replay_record_type::END_TICK)) { is_corrupt = true; return false; }
+
+    record.type = static_cast<replay_record_type>(raw_type);
+    switch (record.type)
+    {
+      case replay_record_type::SPAWN:
+           record.entity          = read_handle();
+           record.entity_type     = static_cast<gameplay_entity_type>(read_u8());
+           record.origin_position = read_vector();
+           record.collision_size  = read_vector();
+           break;
+
+      case replay_record_type::DESPAWN:
+           record.entity = read_handle();
+           break;
+
+      case replay_record_type::MOVE_REQUEST:
+           record.entity.id                                = static_cast<int>(read_u32());
+           record.move_request.current_origin_position     = read_vector();
+           record.move_request.destination_origin_position = read_vector();
+           record.move_request.velocity                    = read_vector();
+           break;
+
+      case replay_record_type::END_TICK:
+      {
+        record.tick = read_u32();
+        std::uint64_t low = read_u32();
+        record.state_hash = low | (static_cast<std::uint64_t>(read_u32()) << 32);
+        break;
+      }
+    }
+
+    return !is_corrupt;
+  }
+
+  private:
+    std::uint8_t read_u8()
+    {
+      int value = fgetc(file);
+      if (value == EOF) { is_corrupt = true; return 0; }
+      return static_cast<std::uint8_t>(value);
+    }
+
+    std::uint32_t read_u32()
+    {
+      std::uint32_t value = 0;
+      for(int shift=0; shift < 32; shift += 8) value |= static_cast<std::uint32_t>(read_u8()) << shift;
+      return value;
+    }
+
+    float read_f32()
+    {
+      std::uint32_t bits = read_u32();
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+    sf::Vector2f read_vector()
+    {
+      float x = read_f32();
+      return sf::Vector2f(x, read_f32());
+    }
+
+    gameplay_entity_handle read_handle()
+    {
+      gameplay_entity_handle handle;
+      handle.id         = static_cast<int>(read_u32());
+      handle.generation = read_u32();
+      return handle;
+    }
+};
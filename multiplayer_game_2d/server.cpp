@@ -0,0 +1,765 @@
+#include <iostream>
+#include <string.h>
+#include <bitset>
+#include <cmath>
+#include <cstdlib>
+#include <time.h>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <assert.h>
+#include <limits>
+#include "gameplay.h"
+#include "arena.h"
+#include "fixed_timestep.h"
+#include "net.h"
+#include "protocol.h"
+#include "snapshot.h"
+#include "interest.h"
+#include "match.h"
+#include "replay.h"
+#include "profiler.h"
+
+#ifndef _WIN32
+  #include <pthread.h>
+#endif
+
+
+// @remember: headless dedicated server, must never include SFML Graphics/Window/Audio (only header-only SFML/System/Vector2.hpp through gameplay.h)
+// @remember: with a port the server is authoritative for remote players, clients only send input (see protocol.h)
+// @remember: "server matches <match_count> ..." runs many offline matches sharded across pinned threads to measure how many matches a core can tick
+// @remember: "server replay <recording> ..." plays back a match recorded with the record_path argument and reports the first tick that diverged
+
+
+#define DEFAULT_SIMULATION_TICK_RATE       30      // the server can run at a lower tick rate than clients render at
+#define MAX_TICKS_PER_FRAME                5       // bounded catch-up after a stall
+#define RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES  4096    // entity capacity for maps that don't have a compile-time specialization
+
+
+
+/* client stuff */
+struct server_client
+{
+  bool                   is_connected = false;
+  net_address            address;
+  gameplay_entity_handle entity;                                              // the MARIO this client controls
+  input_buffer           inputs;                                              // applied one per tick in sequence order
+  player_move_chamber    move_chamber;
+  float                  seconds_since_receive = 0.0f;
+  std::uint32_t          acked_state_tick      = 0;                           // newest STATE the client decoded, 0 for none
+  std::uint32_t          desync_tick           = 0;                           // first STATE the client decoded to a different hash, dumped once
+  std::unique_ptr<snapshot_ring> sent_snapshots;                              // what the client has for each recently sent tick, the delta baselines
+  std::unique_ptr<area_of_interest> interest;                                 // the entities the client is sent
+  std::unique_ptr<world_snapshot>   view_snapshot;                            // this tick's state of those entities
+};
+
+
+
+template<int p_width, int p_height, int p_max_gameplay_entities>
+int run_server(const float run_seconds, const int tick_rate, const int map_width, const int map_height, const int port, const int send_rate, const char* const record_path)
+{
+  profiler_name_thread("server");
+
+  udp_socket server_socket;
+  if (port > 0)
+  {
+    if ( !net_startup() || !server_socket.open(static_cast<std::uint16_t>(port)) )
+    {
+      std::cout << "could not open udp port " << port << std::endl;
+      return 1;
+    }
+  }
+
+
+
+  /* create match */
+  typedef match<p_width,p_height,p_max_gameplay_entities> server_match;
+  server_match* game = new server_match(map_width, map_height, static_cast<unsigned int>(time(NULL)));
+
+  replay_writer recorder;
+  if (record_path)
+  {
+    replay_header header;
+    header.map_width       = static_cast<std::uint32_t>(map_width);
+    header.map_height      = static_cast<std::uint32_t>(map_height);
+    header.entity_capacity = p_max_gameplay_entities;
+    header.tick_rate       = static_cast<std::uint32_t>(tick_rate);
+    header.seed            = game->seed;
+    header.tile_size_x     = MATCH_TILE_SIZE;
+    header.tile_size_y     = MATCH_TILE_SIZE;
+
+    if ( !recorder.open(record_path, header) )
+    {
+      std::cout << "could not open " << record_path << " for recording" << std::endl;
+      delete game;
+      return 1;
+    }
+    game->recorder = &recorder;
+  }
+
+  tick_time_histograms* timings           = new tick_time_histograms();   // per system, in profiler ticks
+  latency_histogram*    server_tick_times = new latency_histogram();      // simulating and sending STATE, in ns
+  game->timings = timings;
+
+  tile_map<p_width,p_height>* const                                                                   test_tile_map             = game->test_tile_map;
+  gameplay_entities<p_max_gameplay_entities>* const                                                   all_gameplay_entities     = game->all_gameplay_entities;
+  gameplay_entity_ids_per_tile<p_width,p_height,p_max_gameplay_entities,MAX_ENTITIES_PER_TILE>* const tile_to_gameplay_entities = game->tile_to_gameplay_entities;
+  gameplay_entity_moves<p_max_gameplay_entities,p_width,p_height>* const                              all_entity_moves          = game->all_entity_moves;
+
+  const snapshot_layout state_layout(static_cast<std::uint32_t>(test_tile_map->tile_count), p_max_gameplay_entities);
+  world_snapshot* initial_snapshot = new world_snapshot();  // delta baseline tick 0, the arena without entities, clients generate the same one
+  initial_snapshot->allocate(state_layout);
+  initial_snapshot->capture_bitmap(*test_tile_map);
+  initial_snapshot->is_valid = true;
+
+
+
+  /* create network */
+  server_client* clients = new server_client[MAX_CLIENTS];
+  world_snapshot* current_snapshot = new world_snapshot();
+  current_snapshot->allocate(state_layout);
+  net_packet_batch* incoming = new net_packet_batch();  // datagrams are parsed in place from here
+  net_packet_batch* outgoing = new net_packet_batch();  // replies and STATEs are written straight into here, flushed once per drain and per broadcast
+  net_poller poller;
+  const bool is_polling = server_socket.is_open() && poller.add(server_socket);
+  long long received_byte_count   = 0;
+  long long full_state_count      = 0;   // deltas against the initial baseline
+  long long delta_state_count     = 0;
+  long long relevant_entity_count = 0;   // summed over every STATE sent
+
+  auto next_send_buffer = [&]() -> std::uint8_t*  // NET_MAX_PACKET_SIZE bytes to write the next datagram into, queue it with queue_send
+  {
+    if (outgoing->is_full()) send_batch(server_socket, *outgoing);
+    return outgoing->next_buffer();
+  };
+
+  auto queue_send = [&](const net_address& address, const int size)
+  {
+    outgoing->push(address, size);
+  };
+
+  auto send_header_only = [&](const net_address& address, const packet_type type)
+  {
+    byte_writer writer(next_send_buffer(), NET_MAX_PACKET_SIZE);
+    write_packet_header(writer, type);
+    queue_send(address, writer.size);
+  };
+
+  int spawn_scan_start = 0;
+  auto spawn_player = [&]() -> gameplay_entity_handle  // on the first empty floor tile, scanning from a spread out start so players don't pile up
+  {
+    const sf::Vector2f collision_size(test_tile_map->tile_size_x - 2.0f, test_tile_map->tile_size_y - 2.0f);
+
+    for(int offset=0; offset < test_tile_map->tile_count; ++offset)
+    {
+      int tile_index = (spawn_scan_start + offset) % test_tile_map->tile_count;
+      if ( (test_tile_map->bitmap[tile_index] == static_cast<int>(tile_map_bitmap_type::WALL)) || (tile_to_gameplay_entities->bucket(tile_index).count != 0) ) continue;
+
+      sf::Vector2f origin_position( (test_tile_map->tile_size_x * (tile_index % test_tile_map->width)) + 1.0f, (test_tile_map->tile_size_y * (tile_index / test_tile_map->width)) + 1.0f );
+      gameplay_entity_handle handle = game->spawn_entity(gameplay_entity_type::MARIO, origin_position, collision_size);
+      if (handle.id == -1) return handle;
+
+      spawn_scan_start = (tile_index + (test_tile_map->tile_count / MAX_CLIENTS) + 1) % test_tile_map->tile_count;
+      return handle;
+    }
+
+    return gameplay_entity_handle();
+  };
+
+  auto disconnect_client = [&](server_client& client)
+  {
+    game->despawn_entity(client.entity);
+    client = server_client();
+  };
+
+  auto receive_client_packets = [&]()
+  {
+    while ( receive_batch(server_socket, *incoming) > 0 )
+    {
+      for(int packet=0; packet < incoming->count; ++packet)
+      {
+        const net_address& source = incoming->addresses[packet];
+        const int          size   = incoming->sizes[packet];
+        byte_reader reader(incoming->buffers[packet], size);
+        packet_type type;
+        if ( !read_packet_header(reader, type) ) continue;
+
+        received_byte_count += size;
+
+        server_client* client = nullptr;
+        for(int i=0; i < MAX_CLIENTS; ++i)
+        {
+          if (clients[i].is_connected && (clients[i].address == source)) client = &clients[i];
+        }
+
+        if (type == packet_type::CONNECT_REQUEST)
+        {
+          if (!client)
+          {
+            for(int i=0; (i < MAX_CLIENTS) && !client; ++i)
+            {
+              if (!clients[i].is_connected) client = &clients[i];
+            }
+
+            gameplay_entity_handle entity = client ? spawn_player() : gameplay_entity_handle();
+            if (entity.id == -1)
+            {
+              send_header_only(source, packet_type::CONNECT_DENIED);
+              continue;
+            }
+
+            client->is_connected = true;
+            client->address      = source;
+            client->entity       = entity;
+            client->sent_snapshots.reset(new snapshot_ring(state_layout));
+            client->interest.reset(new area_of_interest(p_max_gameplay_entities));
+            client->view_snapshot.reset(new world_snapshot());
+            client->view_snapshot->allocate(state_layout);
+
+            char address_string[32];
+            source.to_string(address_string, sizeof(address_string));
+            std::cout << "client " << address_string << " connected as entity " << entity.id << std::endl;
+          }
+
+          // (re)send accept, the first one may have been lost
+          connect_accept_message accept;
+          accept.entity_id   = client->entity.id;
+          accept.tick_rate   = static_cast<std::uint16_t>(tick_rate);
+          accept.map_width   = static_cast<std::uint16_t>(test_tile_map->width);
+          accept.map_height      = static_cast<std::uint16_t>(test_tile_map->height);
+          accept.entity_capacity = p_max_gameplay_entities;
+          accept.tile_size_x     = test_tile_map->tile_size_x;
+          accept.tile_size_y     = test_tile_map->tile_size_y;
+
+          byte_writer writer(next_send_buffer(), NET_MAX_PACKET_SIZE);
+          write_packet_header(writer, packet_type::CONNECT_ACCEPT);
+          accept.write(writer);
+          queue_send(source, writer.size);
+
+          client->seconds_since_receive = 0.0f;
+          continue;
+        }
+
+        if (!client) continue;
+        client->seconds_since_receive = 0.0f;
+
+        switch (type)
+        {
+          case packet_type::INPUT:
+          {
+            input_message input;
+            if ( !input.read(reader) ) break;
+
+            client->inputs.receive(input);
+
+            if ( sequence_greater_than(input.acked_state_tick, client->acked_state_tick) ) client->acked_state_tick = input.acked_state_tick;
+
+            if ( (input.desync_tick != 0) && (client->desync_tick == 0) )
+            {
+              // what the client should have had, diff it against the client's own dump
+              client->desync_tick = input.desync_tick;
+              const world_snapshot* sent = client->sent_snapshots->find(input.desync_tick, input.desync_tick);
+
+              char path[64];
+              snprintf(path, sizeof(path), "desync_%u_entity_%d_server.txt", input.desync_tick, client->entity.id);
+              std::cout << "client (entity " << client->entity.id << ") desynced at tick " << input.desync_tick;
+              if ( sent && write_snapshot_dump(path, *sent, state_layout, test_tile_map->width) ) std::cout << ", dumped to " << path << std::endl;
+              else                                                                              std::cout << ", too old to dump" << std::endl;
+            }
+            break;
+          }
+
+          case packet_type::DISCONNECT:
+               std::cout << "client disconnected (entity " << client->entity.id << ", " << client->inputs.starved_count << " ticks without input" << (client->desync_tick ? ", desynced" : "") << ")" << std::endl;
+               disconnect_client(*client);
+               break;
+
+          default:
+               break;
+        }
+      }
+
+      if (incoming->count < NET_BATCH_SIZE) break;  // drained
+    }
+
+    send_batch(server_socket, *outgoing);
+  };
+
+  auto broadcast_state = [&](const long long tick)
+  {
+    PROFILE_ZONE("broadcast state");
+    const std::uint32_t state_tick = static_cast<std::uint32_t>(tick);
+    current_snapshot->capture_bitmap(*test_tile_map);  // entities are captured per client, only what each can see
+
+    for(int i=0; i < MAX_CLIENTS; ++i)
+    {
+      if (!clients[i].is_connected) continue;
+
+      const int center_tile_index = test_tile_map->calculate_tile_map_index( all_entity_moves->current_origin_position(clients[i].entity.id) );
+      clients[i].interest->update(center_tile_index, *test_tile_map, *tile_to_gameplay_entities);
+
+      world_snapshot& view_snapshot = *clients[i].view_snapshot;
+      view_snapshot.capture_entities(state_tick, clients[i].interest->relevant_ids.get(), clients[i].interest->relevant_count, *all_gameplay_entities, *all_entity_moves, *test_tile_map);
+      view_snapshot.copy_bitmap_from(*current_snapshot, state_layout);
+      relevant_entity_count += clients[i].interest->relevant_count;
+
+      // delta against the newest state the client acked, or the initial state when that is too old or nothing was acked
+      const world_snapshot* baseline = (clients[i].acked_state_tick != 0) ? clients[i].sent_snapshots->find(clients[i].acked_state_tick, state_tick) : nullptr;
+      if (baseline) ++delta_state_count;
+      else          { baseline = initial_snapshot; ++full_state_count; }
+
+      state_message state;
+      state.tick                 = state_tick;
+      state.baseline_tick        = baseline->tick;
+      state.acked_input_sequence    = clients[i].inputs.applied_sequence;
+      state.acked_chamber_direction = clients[i].move_chamber.direction;
+
+      byte_writer writer(next_send_buffer(), NET_MAX_PACKET_SIZE);
+      write_packet_header(writer, packet_type::STATE);
+      state.write(writer, *baseline, view_snapshot, clients[i].sent_snapshots->slot(state_tick), state_layout);
+      assert(!writer.overflowed);
+
+      queue_send(clients[i].address, writer.size);
+    }
+
+    send_batch(server_socket, *outgoing);  // every client's STATE in one sendmmsg
+  };
+
+
+
+  /* run simulation loop */
+  std::chrono::steady_clock::time_point start_time    = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point previous_time = start_time;
+  fixed_timestep_scheduler simulation_scheduler(tick_rate, MAX_TICKS_PER_FRAME);
+  double busy_seconds     = 0.0;   // simulating and sending STATE, what a tick costs on this machine
+  double max_tick_seconds = 0.0;
+  float  seconds_since_histogram_report = 0.0f;
+  const int state_send_interval = ( (send_rate > 0) && (send_rate < tick_rate) ) ? (tick_rate / send_rate) : 1;  // in ticks
+
+  std::cout << "server running " << map_width << "x" << map_height << " match at " << tick_rate << " Hz" << ( (p_width == RUNTIME_TILE_MAP_SIZE) ? " (runtime sized map)" : "" );
+  if (server_socket.is_open()) std::cout << " on udp port " << port << ", sending state every " << state_send_interval << " ticks";
+  std::cout << std::endl;
+
+  for(;;)
+  {
+    std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+    float elapsed_frame_time_seconds = std::chrono::duration<float>(current_time - previous_time).count();
+    previous_time = current_time;
+
+    if ( (run_seconds > 0.0f) && (std::chrono::duration<float>(current_time - start_time).count() >= run_seconds) ) break;
+
+    if (server_socket.is_open())
+    {
+      PROFILE_ZONE("receive input");
+      receive_client_packets();
+    }
+
+    // disconnect clients that went quiet
+    for(int i=0; i < MAX_CLIENTS; ++i)
+    {
+      if (!clients[i].is_connected) continue;
+
+      clients[i].seconds_since_receive += elapsed_frame_time_seconds;
+      if (clients[i].seconds_since_receive > CONNECTION_TIMEOUT_SECONDS)
+      {
+        std::cout << "client timed out (entity " << clients[i].entity.id << ")" << std::endl;
+        disconnect_client(clients[i]);
+      }
+    }
+
+    int tick_count_this_frame = simulation_scheduler.advance(elapsed_frame_time_seconds);
+    long long first_tick      = simulation_scheduler.tick_count - tick_count_this_frame;
+
+    for(int tick=0; tick < tick_count_this_frame; ++tick)
+    {
+      std::chrono::steady_clock::time_point tick_start_time = std::chrono::steady_clock::now();
+
+      // remote players use the same move chamber as the local client and client prediction
+      game->tick(simulation_scheduler.tick_seconds, [&](server_match& p_match)
+      {
+        for(int i=0; i < MAX_CLIENTS; ++i)
+        {
+          if (!clients[i].is_connected) continue;
+
+          clients[i].move_chamber.hold(clients[i].inputs.next_direction());
+          clients[i].move_chamber.generate_move_request(clients[i].entity.id, *p_match.all_gameplay_entities, *p_match.all_entity_moves, *p_match.test_tile_map, p_match.all_move_requests);
+        }
+      });
+
+      if ( server_socket.is_open() && (((first_tick + tick + 1) % state_send_interval) == 0) ) broadcast_state(first_tick + tick + 1);
+
+      double tick_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick_start_time).count();
+      busy_seconds += tick_seconds;
+      if (tick_seconds > max_tick_seconds) max_tick_seconds = tick_seconds;
+      server_tick_times->record( static_cast<std::uint64_t>(tick_seconds * 1000000000.0) );
+    } // end of simulation ticks
+
+    seconds_since_histogram_report += elapsed_frame_time_seconds;
+    if (seconds_since_histogram_report >= HISTOGRAM_REPORT_SECONDS)
+    {
+      server_tick_times->print("server", "server tick", 0.001);
+      timings->print("server", profiler_microseconds_per_tick());
+      game->current_movement_stats().print("server");
+      seconds_since_histogram_report = 0.0f;
+    }
+
+    // sleep until the next tick is due instead of spinning, waking early for datagrams so they are read when they arrive and not a tick late
+    if (is_polling) poller.wait(simulation_scheduler.seconds_until_next_tick());
+    else std::this_thread::sleep_for( std::chrono::duration<float>(simulation_scheduler.seconds_until_next_tick()) );
+  } // end of simulation loop
+
+  std::cout << "server ran " << simulation_scheduler.tick_count << " ticks (" << simulation_scheduler.dropped_tick_count << " dropped), " << game->triggered_count << " triggers activated, "
+            << ( simulation_scheduler.tick_count ? (busy_seconds * 1000.0 / simulation_scheduler.tick_count) : 0.0 ) << " ms per tick (longest " << (max_tick_seconds * 1000.0) << " ms)" << std::endl;
+  server_tick_times->print("server", "server tick", 0.001);
+  timings->print("server", profiler_microseconds_per_tick());
+  game->current_movement_stats().print("server");
+
+  if (server_socket.is_open())
+  {
+    std::cout << "server sent " << outgoing->byte_count << " bytes (" << delta_state_count << " delta states, " << full_state_count << " full states, "
+              << ( (delta_state_count + full_state_count) ? (relevant_entity_count / (delta_state_count + full_state_count)) : 0 ) << " entities per state), received " << received_byte_count << " bytes" << std::endl;
+
+    for(int i=0; i < MAX_CLIENTS; ++i)
+    {
+      if (clients[i].is_connected) send_header_only(clients[i].address, packet_type::DISCONNECT);
+    }
+    send_batch(server_socket, *outgoing);
+
+    std::cout << "server sent " << outgoing->packet_count << " datagrams in " << outgoing->syscall_count << " send calls (" << outgoing->packets_per_syscall() << " per call), received "
+              << incoming->packet_count << " in " << incoming->syscall_count << " receive calls (" << incoming->packets_per_syscall() << " per call, " << poller.ready_count << " of " << poller.wait_count << " waits woken by a datagram)" << std::endl;
+
+    server_socket.close();
+    net_shutdown();
+  }
+
+  delete outgoing;
+  delete incoming;
+  delete current_snapshot;
+  delete initial_snapshot;
+  delete[] clients;
+
+  if (recorder.is_open()) std::cout << "recorded " << recorder.record_count << " records (seed " << game->seed << ") to " << record_path << std::endl;
+
+  delete game;
+  delete server_tick_times;
+  delete timings;
+
+  write_chrome_trace_if_requested();
+  return 0;
+}
+
+
+
+/* replay stuff */
+template<int p_width, int p_height, int p_max_gameplay_entities>
+int run_replay(replay_reader& reader, const char* const path, const int repeat_count)  // plays a recording back as fast as possible, checking every tick's state hash
+{
+  // @remember: playback runs the same match::tick as the server with the recorded player move requests, so the stress movers and everything else must come out bit-exact
+
+  profiler_name_thread("replay");
+
+  typedef match<p_width,p_height,p_max_gameplay_entities> replay_match;
+
+  if (reader.header.entity_capacity != static_cast<std::uint32_t>(p_max_gameplay_entities))
+  {
+    std::cout << path << " was recorded with " << reader.header.entity_capacity << " entities, this build uses " << p_max_gameplay_entities << " for that map size" << std::endl;
+    return 1;
+  }
+
+  // read everything first so playback timing is only the simulation
+  std::vector<replay_record> records;
+  replay_record record;
+  while ( reader.read(record) ) records.push_back(record);
+  if (reader.is_corrupt) std::cout << path << " is cut off or corrupt, playing back the records before that" << std::endl;
+
+  const float tick_seconds = 1.0f / static_cast<float>(reader.header.tick_rate);
+  std::vector<replay_record*> tick_move_requests;
+  long long tick_count         = 0;
+  long long diverged_tick      = -1;    // first tick whose state hash didn't match, -1 when none did
+  double    simulation_seconds = 0.0;
+  tick_time_histograms* timings = new tick_time_histograms();
+  movement_stats        movement;   // every repeat summed
+
+  for(int repeat=0; repeat < repeat_count; ++repeat)
+  {
+    replay_match* game = new replay_match(static_cast<int>(reader.header.map_width), static_cast<int>(reader.header.map_height), reader.header.seed, reader.header.tile_size_x, reader.header.tile_size_y);
+    game->timings = timings;
+
+    for(replay_record& current : records)
+    {
+      switch (current.type)
+      {
+        case replay_record_type::SPAWN:
+             if (game->spawn_entity(current.entity_type, current.origin_position, current.collision_size) != current.entity) diverged_tick = (diverged_tick == -1) ? game->tick_count + 1 : diverged_tick;
+             break;
+
+        case replay_record_type::DESPAWN:
+             if ( !game->despawn_entity(current.entity) ) diverged_tick = (diverged_tick == -1) ? game->tick_count + 1 : diverged_tick;
+             break;
+
+        case replay_record_type::MOVE_REQUEST:
+             tick_move_requests.push_back(&current);
+             break;
+
+        case replay_record_type::END_TICK:
+        {
+          std::chrono::steady_clock::time_point tick_start_time = std::chrono::steady_clock::now();
+          game->tick(tick_seconds, [&](replay_match& p_match)
+          {
+            for(const replay_record* move_request : tick_move_requests)
+            {
+              if ( (move_request->entity.id >= 0) && (move_request->entity.id < p_max_gameplay_entities) ) p_match.all_move_requests[move_request->entity.id] = move_request->move_request;
+            }
+          });
+          simulation_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tick_start_time).count();
+          tick_move_requests.clear();
+          ++tick_count;
+
+          if ( (diverged_tick == -1) && ((static_cast<std::uint32_t>(game->tick_count) != current.tick) || (game->state_hash() != current.state_hash)) ) diverged_tick = game->tick_count;
+          break;
+        }
+      }
+    }
+
+    movement.merge(game->current_movement_stats());
+    delete game;
+  }
+
+  std::cout << "replayed " << path << " (" << reader.header.map_width << "x" << reader.header.map_height << ", seed " << reader.header.seed << ") " << repeat_count << " times: " << tick_count << " ticks, "
+            << ( tick_count ? (simulation_seconds * 1000000.0 / tick_count) : 0.0 ) << " us per tick" << std::endl;
+  timings->print("replay", profiler_microseconds_per_tick());
+  movement.print("replay");
+  delete timings;
+
+  if (diverged_tick != -1)
+  {
+    std::cout << "diverged from the recording at tick " << diverged_tick << std::endl;
+    return 1;
+  }
+  if (reader.is_corrupt) return 1;
+
+  std::cout << "every tick matched the recording" << std::endl;
+  write_chrome_trace_if_requested();
+  return 0;
+}
+
+
+
+/* multi-match stuff */
+inline bool pin_current_thread(const int core)  // best effort, false when the os refused
+{
+  #ifdef _WIN32
+    return (core < 64) && (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0);
+  #else
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+  #endif
+}
+
+struct match_shard_stats  // written only by the shard's thread until it is joined
+{
+  int       core               = 0;
+  bool      is_pinned          = false;
+  int       match_count        = 0;
+  long long tick_count         = 0;       // shard ticks, each one ticks every match of the shard
+  long long dropped_tick_count = 0;
+  double    busy_seconds       = 0.0;     // time spent ticking matches
+  double    max_tick_seconds   = 0.0;     // longest shard tick
+  double    run_seconds        = 0.0;
+
+  std::unique_ptr<latency_histogram>    shard_tick_times;   // ticking every match of the shard, in ns
+  std::unique_ptr<tick_time_histograms> timings;            // shared by the shard's matches, in profiler ticks
+  movement_stats                        movement;           // every match of the shard summed at the end of the run
+};
+
+template<int p_width, int p_height, int p_max_gameplay_entities>
+void run_match_shard(const int match_count, const unsigned int first_seed, const float run_seconds, const int tick_rate, const int map_width, const int map_height, match_shard_stats& stats)
+{
+  typedef match<p_width,p_height,p_max_gameplay_entities> shard_match;
+
+  stats.is_pinned   = pin_current_thread(stats.core);
+  profiler_name_thread("match shard");
+  stats.match_count = match_count;
+  stats.shard_tick_times.reset(new latency_histogram());
+  stats.timings.reset(new tick_time_histograms());
+
+  // created after pinning so each match's memory is first touched by the core that ticks it
+  std::vector< std::unique_ptr<shard_match> > matches;
+  matches.reserve(match_count);
+  for(int i=0; i < match_count; ++i)
+  {
+    matches.emplace_back( new shard_match(map_width, map_height, first_seed + static_cast<unsigned int>(i)) );
+    matches.back()->timings = stats.timings.get();
+  }
+
+  fixed_timestep_scheduler scheduler(tick_rate, MAX_TICKS_PER_FRAME);
+  std::chrono::steady_clock::time_point start_time    = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point previous_time = start_time;
+
+  for(;;)
+  {
+    std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+    float elapsed_frame_time_seconds = std::chrono::duration<float>(current_time - previous_time).count();
+    previous_time = current_time;
+
+    if (std::chrono::duration<float>(current_time - start_time).count() >= run_seconds) break;
+
+    int tick_count_this_frame = scheduler.advance(elapsed_frame_time_seconds);
+    for(int tick=0; tick < tick_count_this_frame; ++tick)
+    {
+      std::chrono::steady_clock::time_point tick_start_time = std::chrono::steady_clock::now();
+
+      for(std::unique_ptr<shard_match>& shard_match_pointer : matches) shard_match_pointer->tick(scheduler.tick_seconds, [](shard_match&) {});  // no players, only the stress movers
+
+      double tick_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tick_start_time).count();
+      stats.busy_seconds += tick_seconds;
+      if (tick_seconds > stats.max_tick_seconds) stats.max_tick_seconds = tick_seconds;
+      stats.shard_tick_times->record( static_cast<std::uint64_t>(tick_seconds * 1000000000.0) );
+    }
+
+    std::this_thread::sleep_for( std::chrono::duration<float>(scheduler.seconds_until_next_tick()) );
+  }
+
+  for(std::unique_ptr<shard_match>& shard_match_pointer : matches) stats.movement.merge(shard_match_pointer->current_movement_stats());
+
+  stats.tick_count         = scheduler.tick_count;
+  stats.dropped_tick_count = scheduler.dropped_tick_count;
+  stats.run_seconds        = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+template<int p_width, int p_height, int p_max_gameplay_entities>
+int run_matches(const int match_count, const int thread_count, const float run_seconds, const int tick_rate, const int map_width, const int map_height)
+{
+  const int core_count = static_cast<int>(std::thread::hardware_concurrency());
+
+  std::cout << "running " << match_count << " " << map_width << "x" << map_height << " matches at " << tick_rate << " Hz on " << thread_count << " threads (" << core_count << " cores)" << std::endl;
+
+  std::vector<match_shard_stats> stats(thread_count);
+  std::vector<std::thread>       threads;
+
+  // contiguous shards, one thread per core, a match is only ever ticked by its shard's thread
+  int first_match = 0;
+  for(int i=0; i < thread_count; ++i)
+  {
+    int shard_match_count = (match_count / thread_count) + ( (i < (match_count % thread_count)) ? 1 : 0 );
+    stats[i].core = (core_count > 0) ? (i % core_count) : i;
+
+    threads.emplace_back(run_match_shard<p_width,p_height,p_max_gameplay_entities>, shard_match_count, static_cast<unsigned int>(first_match + 1), run_seconds, tick_rate, map_width, map_height, std::ref(stats[i]));
+    first_match += shard_match_count;
+  }
+
+  for(std::thread& thread : threads) thread.join();
+
+  // a core busy for fraction f of the time could tick its match count / f matches before falling behind
+  std::vector<double> core_match_counts(thread_count, 0.0);
+  std::vector<double> core_busy_fractions(thread_count, 0.0);
+  long long dropped_tick_count = 0;
+  latency_histogram*    shard_tick_times = new latency_histogram();
+  tick_time_histograms* timings          = new tick_time_histograms();
+  movement_stats        movement;
+  for(const match_shard_stats& shard : stats)
+  {
+    movement.merge(shard.movement);
+    shard_tick_times->merge(*shard.shard_tick_times);
+    timings->merge(*shard.timings);
+
+    double busy_fraction = (shard.run_seconds > 0.0) ? (shard.busy_seconds / shard.run_seconds) : 0.0;
+    double average_match_tick_microseconds = ( (shard.tick_count > 0) && (shard.match_count > 0) ) ? ((shard.busy_seconds * 1000000.0) / (static_cast<double>(shard.tick_count) * shard.match_count)) : 0.0;
+
+    std::cout << "core " << shard.core << (shard.is_pinned ? "" : " (not pinned)") << ": " << shard.match_count << " matches, " << shard.tick_count << " ticks (" << shard.dropped_tick_count << " dropped), "
+              << (busy_fraction * 100.0) << "% busy, " << average_match_tick_microseconds << " us per match tick, longest tick " << (shard.max_tick_seconds * 1000.0) << " ms" << std::endl;
+
+    core_match_counts[shard.core % thread_count]   += shard.match_count;
+    core_busy_fractions[shard.core % thread_count] += busy_fraction;
+    dropped_tick_count += shard.dropped_tick_count;
+  }
+
+  double matches_per_core_sum = 0.0;
+  int    used_core_count      = 0;
+  for(int core=0; core < thread_count; ++core)
+  {
+    if (core_busy_fractions[core] <= 0.0) continue;
+    matches_per_core_sum += core_match_counts[core] / core_busy_fractions[core];
+    ++used_core_count;
+  }
+
+  std::cout << "matches per core at " << tick_rate << " Hz: " << ( used_core_count ? (matches_per_core_sum / used_core_count) : 0.0 ) << " (" << used_core_count << " cores used, " << dropped_tick_count << " ticks dropped in total)" << std::endl;
+  shard_tick_times->print("matches", "shard tick", 0.001);
+  timings->print("matches", profiler_microseconds_per_tick());
+  movement.print("matches");
+
+  delete timings;
+  delete shard_tick_times;
+
+  write_chrome_trace_if_requested();
+  return 0;
+}
+
+
+
+int main(int argc, char** argv)
+{
+  if ( (argc > 2) && (strcmp(argv[1], "replay") == 0) )
+  {
+    const char* path         = argv[2];
+    const int   repeat_count = (argc > 3) ? atoi(argv[3]) : 1;
+
+    replay_reader reader;
+    if ( !reader.open(path) || (repeat_count < 1) || (reader.header.tick_rate == 0) || (static_cast<int>(reader.header.map_width) < TEST_ARENA_MIN_WIDTH) || (static_cast<int>(reader.header.map_height) < TEST_ARENA_MIN_HEIGHT) )
+    {
+      std::cout << "usage: server replay <recording> [repeat_count], " << path << " isn't a readable recording" << std::endl;
+      return 1;
+    }
+
+    const int map_width  = static_cast<int>(reader.header.map_width);
+    const int map_height = static_cast<int>(reader.header.map_height);
+    if ( (map_width == TILE_MAP_WIDTH) && (map_height == TILE_MAP_HEIGHT) ) return run_replay<TILE_MAP_WIDTH,TILE_MAP_HEIGHT,MAX_GAMEPLAY_ENTITIES>(reader, path, repeat_count);
+    if ( (map_width == 64) && (map_height == 64) )                          return run_replay<64,64,RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES>(reader, path, repeat_count);
+
+    return run_replay<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE,RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES>(reader, path, repeat_count);
+  }
+
+  if ( (argc > 1) && (strcmp(argv[1], "matches") == 0) )
+  {
+    const int   match_count  = (argc > 2) ? atoi(argv[2])                           : 1000;
+    const int   thread_count = (argc > 3) ? atoi(argv[3])                           : static_cast<int>(std::thread::hardware_concurrency());
+    const float run_seconds  = (argc > 4) ? static_cast<float>(atof(argv[4]))      : 10.0f;
+    const int   tick_rate    = (argc > 5) ? atoi(argv[5])                           : DEFAULT_SIMULATION_TICK_RATE;
+    const int   map_width    = (argc > 6) ? atoi(argv[6])                           : TILE_MAP_WIDTH;
+    const int   map_height   = (argc > 7) ? atoi(argv[7])                           : TILE_MAP_HEIGHT;
+
+    if ( (match_count < 1) || (thread_count < 1) || (map_width < TEST_ARENA_MIN_WIDTH) || (map_height < TEST_ARENA_MIN_HEIGHT) )
+    {
+      std::cout << "usage: server matches <match_count> [thread_count] [run_seconds] [tick_rate_hz] [map_width] [map_height], maps are at least " << TEST_ARENA_MIN_WIDTH << "x" << TEST_ARENA_MIN_HEIGHT << std::endl;
+      return 1;
+    }
+
+    if ( (map_width == TILE_MAP_WIDTH) && (map_height == TILE_MAP_HEIGHT) ) return run_matches<TILE_MAP_WIDTH,TILE_MAP_HEIGHT,MAX_GAMEPLAY_ENTITIES>(match_count, thread_count, run_seconds, tick_rate, map_width, map_height);
+    if ( (map_width == 64) && (map_height == 64) )                          return run_matches<64,64,RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES>(match_count, thread_count, run_seconds, tick_rate, map_width, map_height);
+
+    return run_matches<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE,RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES>(match_count, thread_count, run_seconds, tick_rate, map_width, map_height);
+  }
+
+  const float run_seconds = (argc > 1) ? static_cast<float>(atof(argv[1])) : 0.0f;                  // 0 runs forever
+  const int   tick_rate   = (argc > 2) ? atoi(argv[2])                           : DEFAULT_SIMULATION_TICK_RATE;
+  const int   map_width   = (argc > 3) ? atoi(argv[3])                           : TILE_MAP_WIDTH;
+  const int   map_height  = (argc > 4) ? atoi(argv[4])                           : TILE_MAP_HEIGHT;
+  const int   port        = (argc > 5) ? atoi(argv[5])                           : 0;                  // 0 runs offline
+  const int   send_rate   = (argc > 6) ? atoi(argv[6])                           : tick_rate;          // STATE packets per second, clients interpolate between them
+  const char* record_path = (argc > 7) ? argv[7]                                 : nullptr;            // records the match for "server replay"
+
+  if ( (map_width < TEST_ARENA_MIN_WIDTH) || (map_height < TEST_ARENA_MIN_HEIGHT) )
+  {
+    std::cout << "map must be at least " << TEST_ARENA_MIN_WIDTH << "x" << TEST_ARENA_MIN_HEIGHT << std::endl;
+    return 1;
+  }
+
+  // common arena sizes use the compile-time specialized path, everything else is sized at runtime
+  if ( (map_width == TILE_MAP_WIDTH) && (map_height == TILE_MAP_HEIGHT) ) return run_server<TILE_MAP_WIDTH,TILE_MAP_HEIGHT,MAX_GAMEPLAY_ENTITIES>(run_seconds, tick_rate, map_width, map_height, port, send_rate, record_path);
+  if ( (map_width == 64) && (map_height == 64) )                          return run_server<64,64,RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES>(run_seconds, tick_rate, map_width, map_height, port, send_rate, record_path);
+
+  return run_server<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE,RUNTIME_MAP_MAX_GAMEPLAY_ENTITIES>(run_seconds, tick_rate, map_width, map_height, port, send_rate, record_path);
+}
@@ -0,0 +1,683 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include "gameplay.h"
+#include "state_hash.h"
+
+
+/*
+   @remember: entity positions are sent as the tile the entity is on (or moving to) plus, while moving, a 2-bit direction and a quantized progress fraction
+   @remember: this only works because every move is exactly one tile along one axis, revisit if moves ever become free-form
+   @remember: field widths depend on the map and entity capacity (snapshot_layout) so both sides must build the layout from the same CONNECT_ACCEPT
+   @remember: snapshots are sent as deltas against a baseline the client acked, tick 0 is the shared initial match state (no entities, initial bitmap) so a "full" snapshot is just a delta against it
+*/
+
+
+#define SNAPSHOT_TYPE_BITS        2   // gameplay_entity_type
+#define SNAPSHOT_ANIMATION_BITS   2   // animation_index
+#define SNAPSHOT_DIRECTION_BITS   2
+#define SNAPSHOT_PROGRESS_BITS    6   // 1/63 of a tile, about 1 world unit at 64 units per tile
+#define SNAPSHOT_TILE_BITS        3   // tile_map_bitmap_type
+#define SNAPSHOT_RING_SIZE        32  // baselines older than this many ticks fall back to the initial state
+
+
+
+/* bit packing stuff */
+struct bit_writer
+{
+  /* @remember: bits are packed lsb first into little-endian bytes, call flush() before reading size */
+
+  std::uint8_t* const data;
+  const int capacity;                  // in bytes
+  int  size       = 0;                 // whole bytes written to data
+  bool overflowed = false;             // set instead of writing out of bounds, check before sending
+
+  private:
+    std::uint64_t scratch      = 0;
+    int           scratch_bits = 0;
+  public:
+
+  bit_writer(std::uint8_t* const p_data, const int p_capacity) : data(p_data), capacity(p_capacity) {}
+
+  void write_bits(const std::uint32_t value, const int bit_count)  // bit_count is 1 to 32
+  {
+    assert( (bit_count > 0) && (bit_count <= 32) );
+    assert( (bit_count == 32) || (value < (1u << bit_count)) );
+
+    scratch |= static_cast<std::uint64_t>(value) << scratch_bits;
+    scratch_bits += bit_count;
+
+    if (scratch_bits >= 32)
+    {
+      write_scratch_bytes(4);
+      scratch >>= 32;
+      scratch_bits -= 32;
+    }
+  }
+
+  void write_bool(const bool value) { write_bits(value ? 1u : 0u, 1); }
+
+  int bits_written() const { return (size * 8) + scratch_bits; }
+
+  void flush()  // writes the remaining bits, the last byte is padded with zeros
+  {
+    int byte_count = (scratch_bits + 7) / 8;
+    write_scratch_bytes(byte_count);
+    scratch      = 0;
+    scratch_bits = 0;
+  }
+
+  private:
+    void write_scratch_bytes(const int byte_count)
+    {
+      if (size + byte_count > capacity) { overflowed = true; return; }
+
+      for(int i=0; i < byte_count; ++i) data[size + i] = static_cast<std::uint8_t>(scratch >> (i * 8));
+      size += byte_count;
+    }
+};
+
+struct bit_reader
+{
+  const std::uint8_t* const data;
+  const int size;                      // in bytes
+  int  position   = 0;                 // next byte to load into scratch
+  bool overflowed = false;             // set when reading past the end, values read after that are 0
+
+  private:
+    std::uint64_t scratch      = 0;
+    int           scratch_bits = 0;
+  public:
+
+  bit_reader(const std::uint8_t* const p_data, const int p_size) : data(p_data), size(p_size) {}
+
+  std::uint32_t read_bits(const int bit_count)  // bit_count is 1 to 32
+  {
+    assert( (bit_count > 0) && (bit_count <= 32) );
+
+    while (scratch_bits < bit_count)
+    {
+      if (position >= size) { overflowed = true; return 0; }
+
+      scratch |= static_cast<std::uint64_t>(data[position]) << scratch_bits;
+      scratch_bits += 8;
+      ++position;
+    }
+
+    std::uint32_t value = static_cast<std::uint32_t>( scratch & ((static_cast<std::uint64_t>(1) << bit_count) - 1) );
+    scratch >>= bit_count;
+    scratch_bits -= bit_count;
+    return value;
+  }
+
+  bool read_bool() { return read_bits(1) != 0; }
+};
+
+inline int bits_required(const std::uint32_t value_count)  // bits needed to store values 0 to value_count - 1, at least 1
+{
+  int bit_count = 1;
+  while ( (bit_count < 32) && ((static_cast<std::uint64_t>(1) << bit_count) < value_count) ) ++bit_count;
+  return bit_count;
+}
+
+
+
+/* snapshot stuff */
+enum class snapshot_move_direction : std::uint8_t
+{
+  LEFT  = 0,
+  RIGHT = 1,
+  UP    = 2,
+  DOWN  = 3
+};
+
+struct snapshot_layout  // field widths that depend on the match
+{
+  std::uint32_t tile_count      = 0;
+  std::uint32_t entity_capacity = 0;   // ids are below this
+  int           tile_index_bits = 1;
+  int           id_bits         = 1;
+
+  snapshot_layout() = default;
+  snapshot_layout(const std::uint32_t p_tile_count, const std::uint32_t p_entity_capacity) : tile_count(p_tile_count), entity_capacity(p_entity_capacity), tile_index_bits(bits_required(p_tile_count)), id_bits(bits_required(p_entity_capacity)) {}
+
+  int max_entity_bits() const
+  {
+    return id_bits + SNAPSHOT_TYPE_BITS + SNAPSHOT_ANIMATION_BITS + tile_index_bits + 1 + SNAPSHOT_DIRECTION_BITS + SNAPSHOT_PROGRESS_BITS;
+  }
+
+  int id_bound_bits() const { return bits_required(entity_capacity + 1); }  // counts of entities, can equal entity_capacity
+  int tile_change_count_bits() const { return bits_required(tile_count + 1); }
+
+  int max_delta_entity_bits() const  // id, present and 3 field flags then every field
+  {
+    return 4 + max_entity_bits();
+  }
+
+  int max_delta_entity_count(const int byte_count) const  // entity changes past this aren't sent so the entity part of a delta always fits in byte_count
+  {
+    int count = ((byte_count * 8) - id_bound_bits() - tile_change_count_bits()) / max_delta_entity_bits();
+    return (count < static_cast<int>(entity_capacity)) ? count : static_cast<int>(entity_capacity);
+  }
+};
+
+struct snapshot_entity
+{
+  int                     id              = -1;
+  gameplay_entity_type    type            = gameplay_entity_type::NONE;
+  std::uint8_t            animation_index = 0;
+  int                     tile_index      = 0;      // the tile the entity is on, or moving to
+  bool                    is_moving       = false;
+  snapshot_move_direction direction       = snapshot_move_direction::LEFT;  // only meaningful while moving
+  std::uint8_t            progress        = 0;      // quantized fraction of the move done, only meaningful while moving
+
+  bool is_present() const { return id != -1; }
+
+  std::uint64_t hash() const
+  {
+    state_hasher hasher;
+    hasher.add(static_cast<std::uint32_t>(id));
+    hasher.add(static_cast<std::uint32_t>(type));
+    hasher.add(static_cast<std::uint32_t>(animation_index));
+    hasher.add(static_cast<std::uint32_t>(tile_index));
+    hasher.add(static_cast<std::uint32_t>(is_moving));
+    hasher.add(is_moving ? ((static_cast<std::uint32_t>(direction) << 8) | progress) : 0u);  // both are meaningless while stopped
+    return hasher.value;
+  }
+
+  bool operator==(const snapshot_entity& other) const
+  {
+    return (id == other.id) && (type == other.type) && (animation_index == other.animation_index) && (tile_index == other.tile_index) &&
+           (is_moving == other.is_moving) && (direction == other.direction) && (progress == other.progress);
+  }
+  bool operator!=(const snapshot_entity& other) const { return !(*this == other); }
+
+  void write(bit_writer& writer, const snapshot_layout& layout) const
+  {
+    writer.write_bits(static_cast<std::uint32_t>(id), layout.id_bits);
+    writer.write_bits(static_cast<std::uint32_t>(type), SNAPSHOT_TYPE_BITS);
+    writer.write_bits(animation_index, SNAPSHOT_ANIMATION_BITS);
+    writer.write_bits(static_cast<std::uint32_t>(tile_index), layout.tile_index_bits);
+    writer.write_bool(is_moving);
+
+    if (is_moving)
+    {
+      writer.write_bits(static_cast<std::uint32_t>(direction), SNAPSHOT_DIRECTION_BITS);
+      writer.write_bits(progress, SNAPSHOT_PROGRESS_BITS);
+    }
+  }
+
+  bool read(bit_reader& reader, const snapshot_layout& layout)  // false on overflow or out of range values
+  {
+    id              = static_cast<int>(reader.read_bits(layout.id_bits));
+    type            = static_cast<gameplay_entity_type>(reader.read_bits(SNAPSHOT_TYPE_BITS));
+    animation_index = static_cast<std::uint8_t>(reader.read_bits(SNAPSHOT_ANIMATION_BITS));
+    tile_index      = static_cast<int>(reader.read_bits(layout.tile_index_bits));
+    is_moving       = reader.read_bool();
+    direction       = snapshot_move_direction::LEFT;
+    progress        = 0;
+
+    if (is_moving)
+    {
+      direction = static_cast<snapshot_move_direction>(reader.read_bits(SNAPSHOT_DIRECTION_BITS));
+      progress  = static_cast<std::uint8_t>(reader.read_bits(SNAPSHOT_PROGRESS_BITS));
+    }
+
+    return !reader.overflowed && (static_cast<std::uint32_t>(id) < layout.entity_capacity) && (static_cast<std::uint32_t>(tile_index) < layout.tile_count) &&
+           (type != gameplay_entity_type::NONE) && (type <= gameplay_entity_type::BOMB);
+  }
+};
+
+template<int max_entity_count, int tile_map_width, int tile_map_height>
+snapshot_entity quantize_entity(const int id, const gameplay_entities<max_entity_count>& p_gameplay_entities, const gameplay_entity_moves<max_entity_count,tile_map_width,tile_map_height>& p_entity_moves, const tile_map<tile_map_width,tile_map_height>& p_tile_map)
+{
+  static constexpr int max_progress = (1 << SNAPSHOT_PROGRESS_BITS) - 1;
+
+  snapshot_entity entity;
+  entity.id              = id;
+  entity.type            = p_gameplay_entities.types[id];
+  entity.animation_index = static_cast<std::uint8_t>(p_gameplay_entities.animation_indexes[id]);
+  entity.is_moving       = p_entity_moves.is_moving(id);
+  entity.tile_index      = p_tile_map.calculate_tile_map_index( entity.is_moving ? p_entity_moves.destination_origin_position(id) : p_entity_moves.current_origin_position(id) );  // destinations are only set once an entity has moved
+
+  assert( p_gameplay_entities.animation_indexes[id] < (1 << SNAPSHOT_ANIMATION_BITS) );
+
+  if (entity.is_moving)
+  {
+    float remaining_fraction;
+    const float velocity_x = p_entity_moves.velocity_x[id];
+    const float velocity_y = p_entity_moves.velocity_y[id];
+
+    if (velocity_x)
+    {
+      entity.direction   = (velocity_x < 0.0f) ? snapshot_move_direction::LEFT : snapshot_move_direction::RIGHT;
+      remaining_fraction = std::abs(p_entity_moves.destination_origin_x[id] - p_entity_moves.current_origin_x[id]) / p_tile_map.tile_size_x;
+    }
+    else
+    {
+      entity.direction   = (velocity_y < 0.0f) ? snapshot_move_direction::UP : snapshot_move_direction::DOWN;
+      remaining_fraction = std::abs(p_entity_moves.destination_origin_y[id] - p_entity_moves.current_origin_y[id]) / p_tile_map.tile_size_y;
+    }
+
+    int progress = static_cast<int>( ((1.0f - remaining_fraction) * max_progress) + 0.5f );
+    if (progress < 0)            progress = 0;
+    if (progress > max_progress) progress = max_progress;
+    entity.progress = static_cast<std::uint8_t>(progress);
+  }
+
+  return entity;
+}
+
+template<int p_width, int p_height>
+sf::Vector2f dequantize_origin_position(const snapshot_entity& entity, const tile_map<p_width,p_height>& p_tile_map)  // in the caller's world units
+{
+  static constexpr float max_progress = static_cast<float>( (1 << SNAPSHOT_PROGRESS_BITS) - 1 );
+
+  // the collision origin is inset by 1.0f from the tile corner
+  sf::Vector2f origin_position( (p_tile_map.tile_size_x * (entity.tile_index % p_tile_map.width)) + 1.0f, (p_tile_map.tile_size_y * (entity.tile_index / p_tile_map.width)) + 1.0f );
+  if (!entity.is_moving) return origin_position;
+
+  // step back from the destination by the part of the move that is left
+  const float remaining_fraction = 1.0f - (entity.progress / max_progress);
+  switch (entity.direction)
+  {
+    case snapshot_move_direction::LEFT:  origin_position.x += remaining_fraction * p_tile_map.tile_size_x; break;
+    case snapshot_move_direction::RIGHT: origin_position.x -= remaining_fraction * p_tile_map.tile_size_x; break;
+    case snapshot_move_direction::UP:    origin_position.y += remaining_fraction * p_tile_map.tile_size_y; break;
+    case snapshot_move_direction::DOWN:  origin_position.y -= remaining_fraction * p_tile_map.tile_size_y; break;
+  }
+
+  return origin_position;
+}
+
+
+
+/* delta snapshot stuff */
+#define SNAPSHOT_BITMAP_VERSION_UNKNOWN  0u   // the bitmap has to be compared tile by tile
+
+inline std::uint32_t next_snapshot_bitmap_version()  // unique per captured bitmap so equal versions mean equal bitmaps
+{
+  static std::atomic<std::uint32_t> version(SNAPSHOT_BITMAP_VERSION_UNKNOWN);
+  return ++version;
+}
+
+struct world_snapshot  // the replicated state of a match (or of what one client can see) at one tick, indexed by entity id
+{
+  /*
+     @remember: present entities are also listed in present_ids so copying, clearing and diffing cost the number of present entities instead of entity_capacity
+     @remember: id_bound only grows until the next clear, loop over present_ids rather than up to it
+     @remember: entity_hash and bitmap_hash follow every change (see state_hash.h), only change entities and tiles through set_entity, remove_entity and set_tile
+  */
+
+  std::uint32_t                      tick           = 0;
+  bool                               is_valid       = false;   // false for unused ring slots
+  int                                id_bound       = 0;       // entities at or above this are absent
+  std::unique_ptr<snapshot_entity[]> entities;                 // entity_capacity, absent entities have id -1
+  std::unique_ptr<int[]>             present_ids;              // present_count ids in no particular order
+  int                                present_count  = 0;
+  std::unique_ptr<std::uint8_t[]>    bitmap;                   // tile_count tile_map_bitmap_type values
+  std::uint32_t                      bitmap_version = SNAPSHOT_BITMAP_VERSION_UNKNOWN;
+  std::uint64_t                      entity_hash    = 0;       // sum of the present entities' hashes
+  std::uint64_t                      bitmap_hash    = 0;       // sum of the tiles' hashes
+
+  private:
+    std::unique_ptr<int[]> present_indexes;                    // where each present id is in present_ids
+  public:
+
+  std::uint64_t hash() const { return state_hash_combine(entity_hash, bitmap_hash); }
+
+  void allocate(const snapshot_layout& layout)
+  {
+    entities.reset(new snapshot_entity[layout.entity_capacity]);
+    present_ids.reset(new int[layout.entity_capacity]);
+    present_indexes.reset(new int[layout.entity_capacity]);
+    bitmap.reset(new std::uint8_t[layout.tile_count]);
+    memset(bitmap.get(), 0, layout.tile_count);
+    entity_hash = 0;
+    bitmap_hash = 0;
+  }
+
+  void set_entity(const snapshot_entity& entity)
+  {
+    const int id = entity.id;
+    if (!entities[id].is_present())
+    {
+      present_indexes[id]         = present_count;
+      present_ids[present_count]  = id;
+      ++present_count;
+      if (id >= id_bound) id_bound = id + 1;
+    }
+    else entity_hash -= entities[id].hash();
+
+    entities[id] = entity;
+    entity_hash += entity.hash();
+  }
+
+  void remove_entity(const int id)
+  {
+    if (!entities[id].is_present()) return;
+
+    // swap remove
+    --present_count;
+    const int moved_id = present_ids[present_count];
+    present_ids[present_indexes[id]] = moved_id;
+    present_indexes[moved_id]        = present_indexes[id];
+
+    entity_hash -= entities[id].hash();
+    entities[id] = snapshot_entity();
+  }
+
+  void clear_entities()
+  {
+    for(int i=0; i < present_count; ++i) entities[present_ids[i]] = snapshot_entity();
+    present_count = 0;
+    id_bound      = 0;
+    entity_hash   = 0;
+  }
+
+  void copy_from(const world_snapshot& other, const snapshot_layout& layout)
+  {
+    clear_entities();
+    for(int i=0; i < other.present_count; ++i)
+    {
+      const int id = other.present_ids[i];
+      entities[id]        = other.entities[id];
+      present_ids[i]      = id;
+      present_indexes[id] = i;
+    }
+
+    present_count = other.present_count;
+    tick          = other.tick;
+    is_valid      = other.is_valid;
+    id_bound      = other.id_bound;
+    entity_hash   = other.entity_hash;
+    copy_bitmap_from(other, layout);
+  }
+
+  void copy_bitmap_from(const world_snapshot& other, const snapshot_layout& layout)
+  {
+    if ( (bitmap_version != SNAPSHOT_BITMAP_VERSION_UNKNOWN) && (bitmap_version == other.bitmap_version) ) return;
+
+    memcpy(bitmap.get(), other.bitmap.get(), layout.tile_count);
+    bitmap_version = other.bitmap_version;
+    bitmap_hash    = other.bitmap_hash;
+  }
+
+  void set_tile(const std::uint32_t tile, const std::uint8_t value)
+  {
+    bitmap_hash -= state_hash_tile(static_cast<int>(tile), bitmap[tile]);
+    bitmap[tile] = value;
+    bitmap_hash += state_hash_tile(static_cast<int>(tile), value);
+  }
+
+  template<int max_entity_count, int tile_map_width, int tile_map_height>
+  void capture(const std::uint32_t p_tick, const gameplay_entities<max_entity_count>& p_gameplay_entities, const gameplay_entity_moves<max_entity_count,tile_map_width,tile_map_height>& p_entity_moves, const tile_map<tile_map_width,tile_map_height>& p_tile_map)  // every live entity and the bitmap
+  {
+    capture_entities(p_tick, p_gameplay_entities.live_ids, p_gameplay_entities.live_count, p_gameplay_entities, p_entity_moves, p_tile_map);
+    capture_bitmap(p_tile_map);
+  }
+
+  template<int max_entity_count, int tile_map_width, int tile_map_height>
+  void capture_entities(const std::uint32_t p_tick, const int* const ids, const int id_count, const gameplay_entities<max_entity_count>& p_gameplay_entities, const gameplay_entity_moves<max_entity_count,tile_map_width,tile_map_height>& p_entity_moves, const tile_map<tile_map_width,tile_map_height>& p_tile_map)  // only the given live ids, e.g. what one client can see
+  {
+    clear_entities();
+
+    tick     = p_tick;
+    is_valid = true;
+
+    for(int i=0; i < id_count; ++i) set_entity( quantize_entity(ids[i], p_gameplay_entities, p_entity_moves, p_tile_map) );
+  }
+
+  template<int p_width, int p_height>
+  void capture_bitmap(const tile_map<p_width,p_height>& p_tile_map)  // the version only changes when a tile did
+  {
+    bool is_changed = bitmap_version == SNAPSHOT_BITMAP_VERSION_UNKNOWN;
+    for(int tile=0; tile < p_tile_map.tile_count; ++tile)
+    {
+      assert( p_tile_map.bitmap[tile] < (1 << SNAPSHOT_TILE_BITS) );
+      if (bitmap[tile] == p_tile_map.bitmap[tile]) continue;
+
+      is_changed = true;
+      set_tile(static_cast<std::uint32_t>(tile), static_cast<std::uint8_t>(p_tile_map.bitmap[tile]));
+    }
+
+    if (is_changed) bitmap_version = next_snapshot_bitmap_version();
+  }
+};
+
+struct snapshot_ring  // the last SNAPSHOT_RING_SIZE snapshots by tick
+{
+  const snapshot_layout layout;
+  world_snapshot        snapshots[SNAPSHOT_RING_SIZE];
+
+  explicit snapshot_ring(const snapshot_layout& p_layout) : layout(p_layout)
+  {
+    for(world_snapshot& snapshot : snapshots) snapshot.allocate(layout);
+  }
+
+  snapshot_ring(const snapshot_ring&) = delete;
+  snapshot_ring& operator=(const snapshot_ring&) = delete;
+
+  const world_snapshot* find(const std::uint32_t tick, const std::uint32_t newest_tick) const  // nullptr when the tick was never stored or a newer tick may overwrite its slot
+  {
+    if ( (newest_tick - tick) >= SNAPSHOT_RING_SIZE ) return nullptr;
+
+    const world_snapshot& snapshot = snapshots[tick % SNAPSHOT_RING_SIZE];
+    return (snapshot.is_valid && (snapshot.tick == tick)) ? &snapshot : nullptr;
+  }
+
+  world_snapshot& slot(const std::uint32_t tick) { return snapshots[tick % SNAPSHOT_RING_SIZE]; }
+};
+
+template<typename p_function>
+inline void for_each_snapshot_change(const world_snapshot& baseline, const world_snapshot& current, p_function&& function)  // function(id) for every entity that differs, in the same order on both sides
+{
+  // entities current has that are new or changed, then entities only the baseline has
+  for(int i=0; i < current.present_count; ++i)
+  {
+    const int id = current.present_ids[i];
+    if (baseline.entities[id] != current.entities[id]) function(id);
+  }
+
+  for(int i=0; i < baseline.present_count; ++i)
+  {
+    const int id = baseline.present_ids[i];
+    if (!current.entities[id].is_present()) function(id);
+  }
+}
+
+inline void write_snapshot_delta(bit_writer& writer, const world_snapshot& baseline, const world_snapshot& current, world_snapshot& sent, const snapshot_layout& layout, const int max_bits)
+{
+  /*
+     @remember: sent becomes baseline plus whatever was written so it is exactly what the client will have once it reads this, store it in the client's ring
+     @remember: entity changes past max_delta_entity_count and tile changes that don't fit stay as they were in the baseline and go out in later deltas
+     @remember: the cost is the present entities of both snapshots, the bitmap is only compared when its version differs
+  */
+
+  assert( (&baseline != &sent) && (&current != &sent) );
+
+  sent.copy_from(baseline, layout);
+  sent.tick     = current.tick;
+  sent.is_valid = true;
+
+  int changed_count = 0;
+  for_each_snapshot_change(baseline, current, [&](const int) { ++changed_count; });
+
+  const int max_changed_count = layout.max_delta_entity_count(max_bits / 8);
+  if (changed_count > max_changed_count) changed_count = max_changed_count;
+  writer.write_bits(static_cast<std::uint32_t>(changed_count), layout.id_bound_bits());
+
+  int written_count = 0;
+  for_each_snapshot_change(baseline, current, [&](const int id)
+  {
+    if (written_count == changed_count) return;
+    ++written_count;
+
+    const snapshot_entity& baseline_entity = baseline.entities[id];
+    const snapshot_entity& current_entity  = current.entities[id];
+
+    writer.write_bits(static_cast<std::uint32_t>(id), layout.id_bits);
+    writer.write_bool(current_entity.is_present());
+    if (!current_entity.is_present())
+    {
+      sent.remove_entity(id);
+      return;
+    }
+
+    sent.set_entity(current_entity);
+
+    const bool is_look_changed   = (baseline_entity.type != current_entity.type) || (baseline_entity.animation_index != current_entity.animation_index);
+    const bool is_tile_changed   = baseline_entity.tile_index != current_entity.tile_index;
+    const bool is_motion_changed = (baseline_entity.is_moving != current_entity.is_moving) || (baseline_entity.direction != current_entity.direction) || (baseline_entity.progress != current_entity.progress);
+
+    writer.write_bool(is_look_changed);
+    writer.write_bool(is_tile_changed);
+    writer.write_bool(is_motion_changed);
+
+    if (is_look_changed)
+    {
+      writer.write_bits(static_cast<std::uint32_t>(current_entity.type), SNAPSHOT_TYPE_BITS);
+      writer.write_bits(current_entity.animation_index, SNAPSHOT_ANIMATION_BITS);
+    }
+
+    if (is_tile_changed) writer.write_bits(static_cast<std::uint32_t>(current_entity.tile_index), layout.tile_index_bits);
+
+    if (is_motion_changed)
+    {
+      writer.write_bool(current_entity.is_moving);
+      if (current_entity.is_moving)
+      {
+        writer.write_bits(static_cast<std::uint32_t>(current_entity.direction), SNAPSHOT_DIRECTION_BITS);
+        writer.write_bits(current_entity.progress, SNAPSHOT_PROGRESS_BITS);
+      }
+    }
+  });
+
+  // changed tiles, as many as fit
+  const bool is_bitmap_same = (baseline.bitmap_version != SNAPSHOT_BITMAP_VERSION_UNKNOWN) && (baseline.bitmap_version == current.bitmap_version);
+  const int  tile_change_bits = layout.tile_index_bits + SNAPSHOT_TILE_BITS;
+  int changed_tile_count = 0;
+  for(std::uint32_t tile=0; (tile < layout.tile_count) && !is_bitmap_same; ++tile)
+  {
+    if (baseline.bitmap[tile] != current.bitmap[tile]) ++changed_tile_count;
+  }
+
+  int fitting_tile_count = (max_bits - writer.bits_written() - layout.tile_change_count_bits()) / tile_change_bits;
+  if (changed_tile_count > fitting_tile_count) sent.bitmap_version = SNAPSHOT_BITMAP_VERSION_UNKNOWN;  // part baseline, part current
+  else if (changed_tile_count > 0)             sent.bitmap_version = current.bitmap_version;
+  if (changed_tile_count > fitting_tile_count) changed_tile_count = fitting_tile_count;
+  writer.write_bits(static_cast<std::uint32_t>(changed_tile_count), layout.tile_change_count_bits());
+
+  for(std::uint32_t tile=0; (tile < layout.tile_count) && (changed_tile_count > 0); ++tile)
+  {
+    if (baseline.bitmap[tile] == current.bitmap[tile]) continue;
+
+    writer.write_bits(tile, layout.tile_index_bits);
+    writer.write_bits(current.bitmap[tile], SNAPSHOT_TILE_BITS);
+    sent.set_tile(tile, current.bitmap[tile]);
+    --changed_tile_count;
+  }
+}
+
+inline bool read_snapshot_delta(bit_reader& reader, const world_snapshot& baseline, world_snapshot& snapshot, const std::uint32_t tick, const snapshot_layout& layout)  // false on malformed data, snapshot is then invalid
+{
+  assert(&baseline != &snapshot);
+
+  snapshot.copy_from(baseline, layout);
+  snapshot.tick     = tick;
+  snapshot.is_valid = false;
+
+  const std::uint32_t changed_count = reader.read_bits(layout.id_bound_bits());
+  if (changed_count > layout.entity_capacity) return false;
+
+  for(std::uint32_t i=0; i < changed_count; ++i)
+  {
+    const std::uint32_t id = reader.read_bits(layout.id_bits);
+    if (id >= layout.entity_capacity) return false;
+
+    if ( !reader.read_bool() )
+    {
+      snapshot.remove_entity(static_cast<int>(id));
+      continue;
+    }
+
+    snapshot_entity entity = snapshot.entities[id];  // unchanged fields come from the baseline
+    entity.id = static_cast<int>(id);
+    const bool is_look_changed   = reader.read_bool();
+    const bool is_tile_changed   = reader.read_bool();
+    const bool is_motion_changed = reader.read_bool();
+
+    if (is_look_changed)
+    {
+      entity.type            = static_cast<gameplay_entity_type>(reader.read_bits(SNAPSHOT_TYPE_BITS));
+      entity.animation_index = static_cast<std::uint8_t>(reader.read_bits(SNAPSHOT_ANIMATION_BITS));
+    }
+
+    if (is_tile_changed) entity.tile_index = static_cast<int>(reader.read_bits(layout.tile_index_bits));
+
+    if (is_motion_changed)
+    {
+      entity.is_moving = reader.read_bool();
+      entity.direction = snapshot_move_direction::LEFT;
+      entity.progress  = 0;
+
+      if (entity.is_moving)
+      {
+        entity.direction = static_cast<snapshot_move_direction>(reader.read_bits(SNAPSHOT_DIRECTION_BITS));
+        entity.progress  = static_cast<std::uint8_t>(reader.read_bits(SNAPSHOT_PROGRESS_BITS));
+      }
+    }
+
+    if ( (static_cast<std::uint32_t>(entity.tile_index) >= layout.tile_count) || (entity.type == gameplay_entity_type::NONE) || (entity.type > gameplay_entity_type::BOMB) ) return false;
+    snapshot.set_entity(entity);
+  }
+
+  const std::uint32_t changed_tile_count = reader.read_bits(layout.tile_change_count_bits());
+  if (changed_tile_count > layout.tile_count) return false;
+  if (changed_tile_count > 0) snapshot.bitmap_version = SNAPSHOT_BITMAP_VERSION_UNKNOWN;  // versions are the server's
+
+  for(std::uint32_t i=0; i < changed_tile_count; ++i)
+  {
+    const std::uint32_t tile  = reader.read_bits(layout.tile_index_bits);
+    const std::uint32_t value = reader.read_bits(SNAPSHOT_TILE_BITS);
+    if (tile >= layout.tile_count) return false;
+
+    snapshot.set_tile(tile, static_cast<std::uint8_t>(value));
+  }
+
+  snapshot.is_valid = !reader.overflowed;
+  return snapshot.is_valid;
+}
+
+inline bool write_snapshot_dump(const char* const path, const world_snapshot& snapshot, const snapshot_layout& layout, const int map_width)  // text both sides of a desync can write and diff, entities by id then the bitmap
+{
+  FILE* file = fopen(path, "w");
+  if (!file) return false;
+
+  fprintf(file, "tick %u hash %016llx (entities %016llx, bitmap %016llx)\n", snapshot.tick, static_cast<unsigned long long>(snapshot.hash()), static_cast<unsigned long long>(snapshot.entity_hash), static_cast<unsigned long long>(snapshot.bitmap_hash));
+
+  for(int id=0; id < snapshot.id_bound; ++id)
+  {
+    const snapshot_entity& entity = snapshot.entities[id];
+    if (!entity.is_present()) continue;
+
+    fprintf(file, "entity %d type %d animation %d tile %d,%d", id, static_cast<int>(entity.type), entity.animation_index, entity.tile_index % map_width, entity.tile_index / map_width);
+    if (entity.is_moving) fprintf(file, " moving %d progress %d", static_cast<int>(entity.direction), entity.progress);
+    fprintf(file, "\n");
+  }
+
+  for(std::uint32_t tile=0; tile < layout.tile_count; ++tile)
+  {
+    fprintf(file, "%d", snapshot.bitmap[tile]);
+    if ( ((tile + 1) % static_cast<std::uint32_t>(map_width)) == 0 ) fprintf(file, "\n");
+  }
+
+  fclose(file);
+  return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+
+
+/*
+   @remember: a state hash is the sum (mod 2^64) of one mixed hash per entity and per non-empty tile, so changing one entity or tile is subtract its old hash, add its new one
+   @remember: the sum doesn't depend on order, two sides agree as long as they hold the same entities and tiles however they got there
+   @remember: empty (0) tiles hash to 0 so a fresh bitmap doesn't need summing
+*/
+
+
+
+/* hash stuff */
+inline std::uint64_t state_hash_mix(std::uint64_t value)  // splitmix64 finalizer, every input bit affects every output bit
+{
+  value ^= value >> 30;
+  value *= 0xBF58476D1CE4E5B9ull;
+  value ^= value >> 27;
+  value *= 0x94D049BB133111EBull;
+  value ^= value >> 31;
+  return value;
+}
+
+struct state_hasher  // hashes one entity or tile from its fields
+{
+  std::uint64_t value = 0x9E3779B97F4A7C15ull;
+
+  void add(const std::uint32_t field) { value = state_hash_mix(value ^ field); }
+
+  void add(const float field)  // by bits, so -0.0f and 0.0f differ like they would in a desync
+  {
+    std::uint32_t bits;
+    memcpy(&bits, &field, sizeof(bits));
+    add(bits);
+  }
+};
+
+inline std::uint64_t state_hash_tile(const int tile_index, const int bitmap_value)
+{
+  if (bitmap_value == 0) return 0;
+
+  state_hasher hasher;
+  hasher.add(static_cast<std::uint32_t>(tile_index) | 0x80000000u);  // tiles and entity ids never hash alike
+  hasher.add(static_cast<std::uint32_t>(bitmap_value));
+  return hasher.value;
+}
+
+inline std::uint64_t state_hash_combine(const std::uint64_t entity_hash, const std::uint64_t tile_hash)
+{
+  return state_hash_mix(entity_hash ^ state_hash_mix(tile_hash));
+}
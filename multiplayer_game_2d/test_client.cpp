@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string.h>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <assert.h>
+#include "gameplay.h"
+#include "fixed_timestep.h"
+#include "net.h"
+#include "protocol.h"
+#include "net_client.h"
+#include "arena.h"
+
+
+// @remember: headless client for testing the server over loopback, run several at once to simulate several players
+
+
+#define MAX_TICKS_PER_FRAME            5
+#define CLIENT_MAX_GAMEPLAY_ENTITIES   4096   // must cover every id the server can send
+#define TICKS_PER_DIRECTION_CHANGE     30
+
+
+
+int main(int argc, char** argv)
+{
+  const char*        server_ip   = (argc > 1) ? argv[1]                                     : "127.0.0.1";
+  const int          server_port = (argc > 2) ? atoi(argv[2])                               : DEFAULT_SERVER_PORT;
+  const float        run_seconds = (argc > 3) ? static_cast<float>(atof(argv[3]))           : 5.0f;
+  const unsigned int seed        = (argc > 4) ? static_cast<unsigned int>(atoi(argv[4]))    : 1;
+
+  if (!net_startup()) return 1;
+
+  net_client* client = new net_client();
+  if ( !client->start(server_ip, static_cast<std::uint16_t>(server_port)) )
+  {
+    std::cout << "could not start client for " << server_ip << ":" << server_port << std::endl;
+    return 1;
+  }
+
+  gameplay_entities<CLIENT_MAX_GAMEPLAY_ENTITIES>*   mirrored_gameplay_entities = new gameplay_entities<CLIENT_MAX_GAMEPLAY_ENTITIES>();
+  replicated_entities<CLIENT_MAX_GAMEPLAY_ENTITIES>* mirrored_entities          = new replicated_entities<CLIENT_MAX_GAMEPLAY_ENTITIES>();
+  tile_map<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE>* mirrored_tile_map       = nullptr;  // created once the server says how big the map is
+  player_prediction<CLIENT_MAX_GAMEPLAY_ENTITIES,RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE>* prediction = nullptr;
+  fixed_timestep_scheduler* client_scheduler = nullptr;                                      // ticks at the server's tick rate so every input is one server tick
+  snapshot_interpolation<CLIENT_MAX_GAMEPLAY_ENTITIES>* interpolation = new snapshot_interpolation<CLIENT_MAX_GAMEPLAY_ENTITIES>();
+
+  std::mt19937 random_generator(seed);
+  std::uniform_int_distribution<int> direction_distribution(0, 4);
+  player_input_direction direction = player_input_direction::NONE;
+
+  std::chrono::steady_clock::time_point start_time    = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point previous_time = start_time;
+
+  for(;;)
+  {
+    std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
+    float elapsed_frame_time_seconds = std::chrono::duration<float>(current_time - previous_time).count();
+    previous_time = current_time;
+
+    if (std::chrono::duration<float>(current_time - start_time).count() >= run_seconds) break;
+
+    client->update(elapsed_frame_time_seconds);
+    interpolation->advance(elapsed_frame_time_seconds);
+    if ( (client->state == net_client_state::DISCONNECTED) || (client->state == net_client_state::DENIED) ) break;
+
+    if ( (client->state == net_client_state::CONNECTED) && !mirrored_tile_map )
+    {
+      mirrored_tile_map = new tile_map<RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE>(client->accept.map_width, client->accept.map_height, client->accept.tile_size_x * client->accept.map_width, client->accept.tile_size_y * client->accept.map_height);
+      generate_test_arena_bitmap(*mirrored_tile_map);
+
+      prediction = new player_prediction<CLIENT_MAX_GAMEPLAY_ENTITIES,RUNTIME_TILE_MAP_SIZE,RUNTIME_TILE_MAP_SIZE>(*mirrored_tile_map);
+      prediction->player_id = client->accept.entity_id;
+      client_scheduler = new fixed_timestep_scheduler(client->accept.tick_rate, MAX_TICKS_PER_FRAME);
+    }
+
+    if (client->has_new_state && mirrored_tile_map)
+    {
+      mirrored_entities->apply(client->latest_state, *mirrored_tile_map, *mirrored_gameplay_entities);
+      prediction->reconcile(client->latest_state, client->latest_acked_input_sequence, client->latest_acked_chamber_direction, *mirrored_tile_map, client_scheduler->tick_seconds);
+      interpolation->push(client->latest_state, client_scheduler->tick_seconds, *mirrored_tile_map);
+      client->has_new_state = false;
+    }
+
+    if (mirrored_tile_map) interpolation->sample(*mirrored_gameplay_entities);  // what a game client would draw this frame
+
+    if (!client_scheduler)
+    {
+      std::this_thread::sleep_for( std::chrono::milliseconds(1) );
+      continue;
+    }
+
+    int tick_count_this_frame = client_scheduler->advance(elapsed_frame_time_seconds);
+    for(int tick=0; tick < tick_count_this_frame; ++tick)
+    {
+      // random walk
+      if (client_scheduler->tick_count % TICKS_PER_DIRECTION_CHANGE == 0) direction = static_cast<player_input_direction>(direction_distribution(random_generator));
+
+      std::uint32_t sequence = client->send_input(direction);
+      prediction->step(sequence, direction, *mirrored_tile_map, client_scheduler->tick_seconds);
+    }
+
+    std::this_thread::sleep_for( std::chrono::duration<float>(client_scheduler->seconds_until_next_tick()) );
+  }
+
+  const char* state_names[] = { "disconnected", "connecting", "connected", "denied" };
+  std::cout << "client " << state_names[static_cast<int>(client->state)] << ", entity " << client->accept.entity_id
+            << ", " << client->received_state_count << " states (last tick " << client->latest_state.tick << ", " << client->undecodable_state_count << " undecodable, " << client->desync_count << " desynced)"
+            << ", " << mirrored_gameplay_entities->live_count << " entities mirrored"
+            << ", sent " << client->sent_byte_count << " bytes, received " << client->received_byte_count << " bytes" << std::endl;
+
+  if ( (client->accept.entity_id != -1) && mirrored_tile_map && !mirrored_gameplay_entities->is_garbage_flags[client->accept.entity_id] )
+  {
+    int own_tile_index = mirrored_tile_map->calculate_tile_map_index(mirrored_gameplay_entities->collision_vertices[client->accept.entity_id * 4]);
+    std::cout << "client entity is on tile " << (own_tile_index % mirrored_tile_map->width) << "," << (own_tile_index / mirrored_tile_map->width) << std::endl;
+  }
+
+  std::cout << "interpolation delay " << (interpolation->delay_seconds * 1000.0f) << " ms (jitter " << (interpolation->jitter_seconds * 1000.0f) << " ms, state every " << (interpolation->snapshot_interval_seconds * 1000.0f) << " ms), "
+            << interpolation->starved_count << " frames rendered past the newest state" << std::endl;
+  if (prediction) std::cout << "prediction corrected " << prediction->correction_count << " times (last by " << prediction->last_correction_distance << " world units)" << std::endl;
+
+  const bool was_connected = client->received_state_count > 0;
+
+  client->disconnect();
+  net_shutdown();
+
+  delete client_scheduler;
+  delete prediction;
+  delete interpolation;
+  delete mirrored_tile_map;
+  delete mirrored_entities;
+  delete mirrored_gameplay_entities;
+  delete client;
+
+  return was_connected ? 0 : 1;
+}